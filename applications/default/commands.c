@@ -13,6 +13,7 @@
 #include "default.h"
 
 static void _CMDCLIDirectory(void);
+static void _CMDCLIDiskStatistics(void);
 
 /**
  * @brief      Execute a system command line command
@@ -36,6 +37,10 @@ bool CMDCLICommand(char *cmd) {
         CONWriteString("%s\r\n",FIOGetCWD());
         return true;
     }
+    if (strcmp(cmd,"disk") == 0) {                                                  // disk, show sector cache statistics
+        _CMDCLIDiskStatistics();
+        return true;
+    }
     if (strcmp(cmd,"cd") == 0 || strcmp(cmd,"cdir") == 0) {                         // CDIR is MOS standard, CD is more common.
         int e = FIOChangeCWD(params);                                               // Try to change directory.
         if (e != 0) CONWriteString("%c%cFailed.\r\n",17,1);                         // Couldn't do so.
@@ -48,15 +53,12 @@ bool CMDCLICommand(char *cmd) {
  * @brief      Display the current directory contents.
  */
 static void _CMDCLIDirectory(void) {
-    int e = 0;
-    char buffer[MAX_FILENAME_SIZE];
+    FIOInfo fInfo;
     int h = FIOOpenDirectory(FIOGetCWD());
-    while (e = FIOReadDirectory(h,buffer),e == 0) {
-        if (buffer[0] != '.') {
-            FIOInfo fInfo;
-            char *fullPath = FIOMapFileName(buffer);
-            FSYSFileInformation(fullPath,&fInfo);
-            CONWriteString("%-24s ",buffer);
+    if (h < 0) return;
+    while (FIOReadDirectoryEx(h,&fInfo) == 0) {                                     // Size and type come with the name.
+        if (fInfo.name[0] != '.') {
+            CONWriteString("%-24s ",fInfo.name);
             if (fInfo.isDirectory) {
                 CONWriteString("<dir>\r\n");
             } else {
@@ -67,6 +69,20 @@ static void _CMDCLIDirectory(void) {
     FIOCloseDirectory(h);
 }
 
+/**
+ * @brief      Display the sector cache statistics
+ */
+static void _CMDCLIDiskStatistics(void) {
+    SECSTATISTICS st;
+    SECGetStatistics(&st);
+    uint32_t reads = st.hits+st.misses;
+    CONWriteString("Cache hits   %u of %u (%u%%)\r\n",st.hits,reads,reads == 0 ? 0 : st.hits*100/reads);
+    CONWriteString("Read ahead   %u sectors\r\n",st.readAhead);
+    CONWriteString("Reads        %u, %u sectors\r\n",st.readTransfers,st.sectorsRead);
+    CONWriteString("Writes       %u, %u sectors\r\n",st.writeTransfers,st.sectorsWritten);
+    CONWriteString("Largest      %u sectors\r\n",st.largestTransfer);
+}
+
 // *COPY <src> <dest> [cp ?]
 // *DELETE <file> [rm ?]
 // *REMOVE <file> [no error if absent]
@@ -6,52 +6,51 @@
 #include "common.h"
 #include "edit.h"
 
+/* Buffer for files read or written a character at a time. */
+static unsigned char file_buffer[512];
+
 void EDT_LoadFile(unsigned char* filename)
 {
-  unsigned int fp;
   int len,curlinelen;
   unsigned char *p;
-  fp = FIOOpen((char*)filename);
-  if((fp & 0x80000000)==0) {    
-    len = FIORead(fp, EDT.gap_start, EDT.gap_end-EDT.gap_start);
-    if (len>0) {
-      //VDUWriteString("Read %d bytes\n",len);
-      p=EDT.gap_start + len;
-      if (*(p-1)!='\n') {
-	*--(EDT.gap_end) = '\n';
+  /* Read the whole file into the gap in one go, then filter it into the end. */
+  len = FIOLoadFile((char*)filename, EDT.gap_start, EDT.gap_end-EDT.gap_start);
+  if (len>0) {
+    //VDUWriteString("Read %d bytes\n",len);
+    p=EDT.gap_start + len;
+    if (*(p-1)!='\n') {
+      *--(EDT.gap_end) = '\n';
+    }
+    curlinelen=0;
+    while (p!=EDT.gap_start) {
+      char c=*--p;
+      if (EDT.gap_start == EDT.gap_end) {
+	// No more room for file.
+	break;
       }
-      curlinelen=0;
-      while (p!=EDT.gap_start) {
-	char c=*--p;
-	if (EDT.gap_start == EDT.gap_end) {
-	  // No more room for file.
-	  break;
+      if (EDT.crlf_flag == 2 && c==13) EDT.crlf_flag = 1;
+      /* Mark file for saving in CR-LF mode. */
+      if (((unsigned)c>=32 && c!=127) || c=='\n' || c=='\t') {
+	/* Filter all control chars but LF and TAB */
+	if (c=='\n') {
+	  curlinelen = 0;
+	  EDT.total_lines++;
+	} else {
+	  curlinelen++;
 	}
-	if (EDT.crlf_flag == 2 && c==13) EDT.crlf_flag = 1;
-	/* Mark file for saving in CR-LF mode. */
-	if (((unsigned)c>=32 && c!=127) || c=='\n' || c=='\t') {
-	  /* Filter all control chars but LF and TAB */
-	  if (c=='\n') {
-	    curlinelen = 0;
-	    EDT.total_lines++;
-	  } else {
-	    curlinelen++;
-	  }
-	  if (curlinelen==254) {
-	    /* Force lines to be at most 254 chars (excluding nl) */
-	    *--(EDT.gap_end) = '\n';
-	    EDT.total_lines++;
-	    if (EDT.gap_start == EDT.gap_end) {
-	      // No more room for file.
-	      break;
-	    }
-	    curlinelen=0;
+	if (curlinelen==254) {
+	  /* Force lines to be at most 254 chars (excluding nl) */
+	  *--(EDT.gap_end) = '\n';
+	  EDT.total_lines++;
+	  if (EDT.gap_start == EDT.gap_end) {
+	    // No more room for file.
+	    break;
 	  }
-	  *--(EDT.gap_end) = c;
+	  curlinelen=0;
 	}
+	*--(EDT.gap_end) = c;
       }
     }
-    FIOClose(fp);
   }
   if (EDT.text_end == EDT.gap_end) {
     *--(EDT.gap_end) = '\n';
@@ -78,52 +77,33 @@ bool EDT_SaveFile(unsigned char* filename)
   FIODeleteFile((char*)EDT.mem_start+BACKFILENAME_OFFS);
   /* Rename current file into backup file, this may fail, don't care  */
   FIORenameFile((char*)filename, (char*)EDT.mem_start+BACKFILENAME_OFFS);
-  /* Create file to save */
-  FIOCreateFile((char*)filename);
-  fp = FIOOpen((char*)filename);
-  if (fp<0) return false;
   if (EDT.crlf_flag != 1) {
-    if (EDT.gap_start > EDT.text_start) {
-      FIOWrite(fp,EDT.text_start,EDT.gap_start - EDT.text_start);
-    }
-    if (EDT.text_end > EDT.gap_end) {
-      FIOWrite(fp,EDT.gap_end, EDT.text_end - EDT.gap_end);
-    }
+    /* Save the text either side of the gap, each in one write. */
+    return FIOSaveFile2((char*)filename,
+			EDT.text_start, EDT.gap_start - EDT.text_start,
+			EDT.gap_end, EDT.text_end - EDT.gap_end) == 0;
   } else {
     unsigned char *p;
+    int err = 0;
+    /* Create file to save */
+    fp = FIOOpenEx((char*)filename,FIO_OPEN_TRUNCATE);
+    if (fp & 0x80000000) return false;
+    /* Buffered, as this writes a character at a time. */
+    FIOSetBuffer(fp,file_buffer,sizeof(file_buffer));
     for (p=EDT.text_start; p<EDT.gap_start; p++) {
       if (*p=='\n')
-	FIOWrite(fp,"\r",1);
-      FIOWrite(fp,p,1);
+	err |= FIOWriteByte(fp,'\r');
+      err |= FIOWriteByte(fp,*p);
     }
     for (p=EDT.gap_end; p<EDT.text_end; p++) {
       if (*p=='\n')
-	FIOWrite(fp,"\r",1);
-      FIOWrite(fp,p,1);
+	err |= FIOWriteByte(fp,'\r');
+      err |= FIOWriteByte(fp,*p);
     }
+    /* The last of the buffer is written when it is closed. */
+    if (FIOClose(fp) != 0) return false;
+    return err == 0;
   }
-  FIOClose(fp);
-  return true;
-}
-
-/* Replacement for fgets as the one in AgDev appears to be broken,
-   does not detect EOF on real machine */
-static char * my_fgets(char *s, unsigned int maxlen, unsigned int f)
-{
-  unsigned int i;
-  char c;
-  for(i=0; i<maxlen-1;) {
-    if (FIORead(f,&c,1) <= 0) break;
-    if (c=='\r') continue;
-    s[i] = c;
-    i++;
-    if (c=='\n') break;
-  }
-  s[i] = 0;
-  if (i==0)
-    return 0;
-  else
-    return s;
 }
 
 static unsigned char *
@@ -146,9 +126,10 @@ void EDT_LoadConfig(char *name)
 {
   unsigned int fp;
   unsigned char *p,*q;
-  fp = FIOOpen(name);
+  fp = FIOOpenEx(name,FIO_OPEN_READ);
   if((fp & 0x80000000)==0) {    
-    while (my_fgets((char*)EDT.text_start, 81, fp)) {
+    FIOSetBuffer(fp,file_buffer,sizeof(file_buffer));
+    while (FIOReadLine(fp,(char*)EDT.text_start, 81) > 0) {
       if (EDT.text_start[0]=='\n' || EDT.text_start[0]=='#') continue;
       /* skip blank lines. */
       p=EDT.text_start;
@@ -0,0 +1,292 @@
+/**
+ * @file       blocks.c
+ *
+ * @brief      Block buffers for the Forth BLOCK words. The buffers are in
+ *             the Forth memory, allotted by the Forth side, and hold 1k
+ *             blocks of a block file. They are reused least recently used
+ *             first, updated blocks being written back to the file.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "common.h"
+#include "sod32.h"
+
+#define FTH_BLOCK_SIZE          (1024)                                              // Bytes in a block
+#define FTH_MAX_BLOCK_BUFFERS   (32)                                                // Most buffers that can be used.
+#define FTH_DEFAULT_BLOCK_FILE  "blocks.fb"
+
+#define NO_BLOCK    (0xFFFFFFFF)                                                    // Buffer is not in use.
+
+static struct _BlockBuffer {
+    UNS32 block;                                                                    // Block held, NO_BLOCK if none
+    UNS32 lastUsed;                                                                 // When it was last used, for LRU.
+    bool  isUpdated;                                                                // Needs writing back
+    UNS32 pins;                                                                     // Being loaded, so not reused.
+} buffers[FTH_MAX_BLOCK_BUFFERS];
+
+static UNS32 bufferArea = 0;                                                        // Forth address of the buffers
+static UNS32 bufferCount = 0;                                                       // Number of buffers, 0 if not set.
+static int current = -1;                                                            // Buffer UPDATE applies to
+static UNS32 useCount = 0;                                                          // Advanced on every use.
+static UNS32 stats[3];                                                              // Hits, misses and writes
+static char blockFile[128];                                                         // Name of the block file.
+
+#define STAT_HITS   (0)
+#define STAT_MISSES (1)
+#define STAT_WRITES (2)
+
+/**
+ * @brief      Get the Forth address of a buffer
+ *
+ * @param[in]  n     Buffer number
+ *
+ * @return     Address in Forth memory
+ */
+static UNS32 _FTH_buffer_address(int n) {
+    return bufferArea+n*FTH_BLOCK_SIZE;
+}
+
+/**
+ * @brief      Open the block file. It is only created when a block is written
+ *             back, so reading a file that is not there is not an error. It
+ *             is not kept open, as Forth closes every file handle after an
+ *             error.
+ *
+ * @param[in]  isWrite  Open to write blocks back
+ *
+ * @return     Handle, FIO_ERR_NOTFOUND if reading a missing file, or Error
+ *             code if negative
+ */
+static int _FTH_block_open(bool isWrite) {
+    if (isWrite) return FIOOpenEx(blockFile,FIO_OPEN_APPEND);                       // Read/write, created if needed.
+    return FIOOpenEx(blockFile,FIO_OPEN_READ);
+}
+
+/**
+ * @brief      Write a buffer back to the block file. Forth memory is held
+ *             as cells, so the bytes are put in file order while writing.
+ *             Any gap between the end of the file and the block is filled
+ *             with spaces, so unwritten blocks read as blank.
+ *
+ * @param[in]  handle  Block file handle
+ * @param[in]  n       Buffer number
+ *
+ * @return     0 or Forth ior
+ */
+static UNS32 _FTH_block_write(int handle,int n) {
+    static char blanks[64];
+    UNS32 addr = _FTH_buffer_address(n);
+    int pos = buffers[n].block*FTH_BLOCK_SIZE;
+    int size = FIOFileSize(handle);
+    int err = (size < 0) ? size : FIOGetSetPosition(handle,min(size,pos));
+    if (err >= 0 && size < pos) memset(blanks,' ',sizeof(blanks));
+    while (err >= 0 && size < pos) {                                                // Fill the gap
+        err = FIOWrite(handle,blanks,min((int)sizeof(blanks),pos-size));
+        size += sizeof(blanks);
+    }
+    FTH_swap_mem(addr,FTH_BLOCK_SIZE);
+    if (err >= 0) err = FIOWrite(handle,FTH.mem+addr,FTH_BLOCK_SIZE);
+    FTH_swap_mem(addr,FTH_BLOCK_SIZE);
+    if (err < 0) return -34;                                                        // Block write exception
+    buffers[n].isUpdated = false;
+    stats[STAT_WRITES]++;
+    return 0;
+}
+
+/**
+ * @brief      Read a block into a buffer. Parts past the end of the file are
+ *             filled with spaces, as is the whole block if there is no file.
+ *
+ * @param[in]  handle  Block file handle, negative if there is no file
+ * @param[in]  n       Buffer number
+ *
+ * @return     0 or Forth ior
+ */
+static UNS32 _FTH_block_read(int handle,int n) {
+    UNS32 addr = _FTH_buffer_address(n);
+    int pos = buffers[n].block*FTH_BLOCK_SIZE;
+    int got = 0;
+    int size = (handle < 0) ? 0 : FIOFileSize(handle);                              // Kept by FIO, no seeking
+    if (size < 0) return -33;
+    if (pos < size) {                                                               // Something to read.
+        if (FIOGetSetPosition(handle,pos) < 0) return -33;
+        got = FIORead(handle,FTH.mem+addr,FTH_BLOCK_SIZE);
+        if (got < 0) return -33;                                                    // Block read exception
+    }
+    memset(FTH.mem+addr+got,' ',FTH_BLOCK_SIZE-got);
+    FTH_swap_mem(addr,FTH_BLOCK_SIZE);
+    return 0;
+}
+
+/**
+ * @brief      Write back every updated buffer, in block order.
+ *
+ * @return     0 or Forth ior
+ */
+static UNS32 _FTH_block_save_all(void) {
+    int handle = -1;
+    UNS32 ior = 0;
+    while (ior == 0) {
+        int next = -1;                                                              // Lowest updated block.
+        for (int i = 0;i < (int)bufferCount;i++) {
+            if (buffers[i].isUpdated && (next < 0 || buffers[i].block < buffers[next].block)) next = i;
+        }
+        if (next < 0) break;                                                        // All written.
+        if (handle < 0) {
+            handle = _FTH_block_open(true);
+            if (handle < 0) return -34;
+        }
+        ior = _FTH_block_write(handle,next);
+    }
+    if (handle >= 0 && FIOClose(handle) < 0 && ior == 0) ior = -34;
+    return ior;
+}
+
+/**
+ * @brief      Empty every buffer, without writing anything back.
+ */
+static void _FTH_block_empty_all(void) {
+    for (int i = 0;i < FTH_MAX_BLOCK_BUFFERS;i++) {
+        buffers[i].block = NO_BLOCK;buffers[i].isUpdated = false;buffers[i].lastUsed = 0;buffers[i].pins = 0;
+    }
+    current = -1;
+}
+
+/**
+ * @brief      Use the buffers the Forth side has allotted. If they have
+ *             moved, anything updated is written back from the old ones
+ *             first.
+ *
+ * @param[in]  area   Forth address of the buffers
+ * @param[in]  count  Number of buffers
+ *
+ * @return     0 or Forth ior
+ */
+static UNS32 _FTH_block_area(UNS32 area,UNS32 count) {
+    if (area == bufferArea && count == bufferCount) return 0;                       // No change.
+    if (count == 0 || count > FTH_MAX_BLOCK_BUFFERS || (area & 3) != 0 ||
+                        area > MEMSIZE || count*FTH_BLOCK_SIZE > MEMSIZE-area) return -24;
+    UNS32 ior = _FTH_block_save_all();
+    _FTH_block_empty_all();
+    bufferArea = area;bufferCount = count;
+    return ior;
+}
+
+/**
+ * @brief      Find a buffer for a block, reading it if required.
+ *
+ * @param[in]  block   Block number
+ * @param[in]  isRead  Read the block from the file if it is not in a buffer
+ * @param      addr    Set to the Forth address of the buffer
+ *
+ * @return     0 or Forth ior
+ */
+static UNS32 _FTH_block_get(UNS32 block,bool isRead,UNS32 *addr) {
+    if (block >= 0x80000000 / FTH_BLOCK_SIZE) return -35;                           // Invalid block number
+    int n = 0;
+    while (n < (int)bufferCount && buffers[n].block != block) n++;                  // Already have it ?
+    if (n < (int)bufferCount) {
+        stats[STAT_HITS]++;
+    } else {
+        stats[STAT_MISSES]++;
+        n = -1;                                                                     // Least recently used, free ones
+        for (int i = 0;i < (int)bufferCount;i++) {                                  // have never been used.
+            if (buffers[i].pins == 0 && (n < 0 || buffers[i].lastUsed < buffers[n].lastUsed)) n = i;
+        }
+        if (n < 0) return isRead ? -33 : -34;                                       // All being loaded.
+        if (buffers[n].isUpdated || isRead) {                                       // Need the file
+            int handle = _FTH_block_open(buffers[n].isUpdated);
+            if (handle == FIO_ERR_NOTFOUND && !buffers[n].isUpdated) handle = -1;   // Not written yet, reads as blank
+            else if (handle < 0) return buffers[n].isUpdated ? -34 : -33;
+            UNS32 ior = buffers[n].isUpdated ? _FTH_block_write(handle,n) : 0;      // Write back the old block
+            if (ior == 0 && isRead) {
+                buffers[n].block = block;
+                ior = _FTH_block_read(handle,n);
+                if (ior != 0) buffers[n].block = NO_BLOCK;                          // Half read, so holds nothing.
+            }
+            if (handle >= 0) FIOClose(handle);
+            if (ior != 0) return ior;
+        }
+        buffers[n].block = block;
+    }
+    buffers[n].lastUsed = ++useCount;
+    current = n;
+    *addr = _FTH_buffer_address(n);
+    return 0;
+}
+
+/**
+ * @brief      Forget all the buffers, the block file and the statistics,
+ *             called when Forth starts.
+ */
+void FTH_block_reset(void) {
+    bufferArea = bufferCount = 0;
+    _FTH_block_empty_all();
+    memset(stats,0,sizeof(stats));
+    strcpy(blockFile,FTH_DEFAULT_BLOCK_FILE);
+}
+
+/**
+ * @brief      Carry out a block OS call. The stack holds ( x area n ) where
+ *             area and n are the buffers allotted by the Forth side, x is
+ *             replaced by the result.
+ *
+ * @param[in]  code   OS call number
+ * @param[in]  area   Forth address of the buffers
+ * @param[in]  count  Number of buffers
+ * @param      x      Parameter and result
+ *
+ * @return     0 or Forth ior
+ */
+UNS32 FTH_block_os(UNS32 code,UNS32 area,UNS32 count,UNS32 *x) {
+    UNS32 ior = _FTH_block_area(area,count);
+    if (ior != 0) return ior;
+    switch(code) {
+        case 20:                                                                    // block
+        case 21:                                                                    // buffer
+            return _FTH_block_get(*x,code == 20,x);
+        case 22:                                                                    // update
+            if (current < 0) return -35;
+            buffers[current].isUpdated = true;
+            break;
+        case 23:                                                                    // save-buffers
+            return _FTH_block_save_all();
+        case 24:                                                                    // empty-buffers
+            _FTH_block_empty_all();
+            break;
+        case 25:                                                                    // block-stats, 0 hits 1 misses 2 writes
+            *x = (*x < 3) ? stats[*x] : 0;
+            break;
+        case 27:                                                                    // block, kept until unpinned
+            ior = _FTH_block_get(*x,true,x);
+            if (ior == 0) buffers[current].pins++;
+            return ior;
+        case 28:                                                                    // unpin block
+            for (int i = 0;i < (int)bufferCount;i++) {
+                if (buffers[i].block == *x && buffers[i].pins > 0) buffers[i].pins--;
+            }
+            break;
+    }
+    return 0;
+}
+
+/**
+ * @brief      Change the block file, writing back and emptying the buffers
+ *             first.
+ *
+ * @param      name  New block file name
+ *
+ * @return     0 or Forth ior
+ */
+UNS32 FTH_block_file(char *name) {
+    if (strlen(name) >= sizeof(blockFile)) return -202;
+    UNS32 ior = _FTH_block_save_all();
+    if (ior != 0) return ior;                                                       // Keep the old file if not saved.
+    _FTH_block_empty_all();
+    strcpy(blockFile,name);
+    return ior;
+}
@@ -5,8 +5,12 @@
 */
 
 #include "sod32.h"
+#include <stdint.h>
+#include "support/profile.h"                                /* Not common.h, which can define BIG_ENDIAN */
 
 
+static UNS32 ops_reported; /* Part of icount already added to PRF_FORTH_OPS */
+
 /* Perform byte swap of 32-bit words in region of memory of virtual machine*/
 void FTH_swap_mem(UNS32 start,UNS32 len) {
 #ifndef BIG_ENDIAN
@@ -77,6 +81,7 @@ void FTH_virtual_machine(void)
  register UNS32 sp,rp,ret,ip,ireg,t;
  register UNS32 icount = 0;
  FTH.interrupt=0;
+ ops_reported=0;
  rp=MEMSIZE;
  sp=MEMSIZE-1024;
  ip=0;
@@ -90,8 +95,9 @@ void FTH_virtual_machine(void)
    FTH.interrupt=0;
   }
   if (icount++ >= 100000) {
+    PRFCount(PRF_FORTH_OPS,icount-ops_reported);
     FTH_check_timer();
-    icount = 0;
+    icount = ops_reported = 0;
   }
   ireg=CELL(ip);
   ip+=4;
@@ -168,8 +174,10 @@ void FTH_virtual_machine(void)
                           goto restart;
                          }
                          FTH.save_sp=sp;FTH.save_ip=ip;FTH.save_rp=rp;
+                         PRFCount(PRF_FORTH_OPS,icount-ops_reported); /* Up to date if the frame ends */
                          FTH_do_special(t);
 			 icount += 100;
+                         ops_reported = icount;
                          sp=FTH.save_sp;ip=FTH.save_ip;rp=FTH.save_rp;
 			 if (FTH.interrupt >= 100)
 			   return;
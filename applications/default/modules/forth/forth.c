@@ -25,5 +25,6 @@ void FTH_ApplicationRun(char *params)
     FTH.load_filename = params;
     FTH.mem = MEMGetMemory()+256;
     load_image();
+    FTH_block_reset();
     FTH_virtual_machine();
 }
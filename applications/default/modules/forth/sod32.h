@@ -42,3 +42,6 @@ int FTH_getch(void);
 int FTH_kbhit(void);
 void FTH_set_alarm(unsigned int);
 void FTH_check_timer(void);
+void FTH_block_reset(void);
+UNS32 FTH_block_os(UNS32,UNS32,UNS32,UNS32 *);
+UNS32 FTH_block_file(char *);
@@ -14,7 +14,8 @@
 int make_name(char *addr,UNS32 len)
 {
  int i;
- for(i=0;i<len && i<256;i++) {
+ if(len>255) return 0;
+ for(i=0;i<len;i++) {
   FTH.filename[i]=addr[i];
  }
  FTH.filename[i]='\0';
@@ -83,25 +84,16 @@ static UNS32 keypressed(UNS32 keycode)
     return  KBDGetStateArray()[keycode];
 }
 
-/* Replacement for fgets as the one in AgDev appears to be broken,
-   does not detect EOF on real machine */
-static char * my_fgets(char *s, unsigned int maxlen, UNS32 f)
-{
-  unsigned int i;
-  char c;
-  for(i=0; i<maxlen-1;) {
-    if (FIORead(f,&c,1) <= 0) break;
-    if (c=='\r') continue;
-    s[i] = c;
-    i++;
-    if (c=='\n') break;
-  }
-  s[i] = 0;
-  if (i==0)
-    return 0;
-  else
-    return s;
-}
+/* Read buffers for open files, so READ-LINE and INCLUDED do not
+   go to the file system for every character. */
+#define FTH_BUFFERED_FILES 4
+static unsigned char file_buffers[FTH_BUFFERED_FILES][512];
+
+/* FIO open modes for R/O, W/O (which CREATE-FILE uses) and R/W,
+   the BIN bit is ignored. */
+static const int open_modes[4] = {
+  FIO_OPEN_READ, FIO_OPEN_TRUNCATE, FIO_OPEN_READWRITE, FIO_OPEN_READWRITE
+};
 
 
 void FTH_do_os(void)
@@ -126,12 +118,12 @@ void FTH_do_os(void)
 	ior=-203;
 	goto end;
       }
-      if ((CELL(FTH.save_sp-4) & 2)!= 0)
-	FIOCreateFile(FTH.filename);
       //CONWriteString("FTH.filename: %s\n",FTH.filename);
-      fp=FIOOpen(FTH.filename);
+      fp=FIOOpenEx(FTH.filename,open_modes[(CELL(FTH.save_sp-4)>>1)&3]);
       //ONWriteString("Open res: %d\n",fp);
       if(fp & 0x80000000)ior=200;
+      else if (fp < FTH_BUFFERED_FILES)
+	FIOSetBuffer(fp,file_buffers[fp],sizeof(file_buffers[fp]));
       CELL(FTH.save_sp+4)=fp;                         
     } goto end;   
  case 8: /*close-file*/  FILEID(CELL(FTH.save_sp));FIOClose(fp); 
@@ -143,16 +135,13 @@ void FTH_do_os(void)
     goto end; 
  case 10: /*read-line*/ FILEID(CELL(FTH.save_sp)); len=CELL(FTH.save_sp+4)+2;
    addr=CELL(FTH.save_sp+8);CLIP(); SWAP();
-   if (my_fgets((char*)(FTH.mem+addr),len,fp)==NULL) {
-     SWAP();
-     //CONWriteString("READ-LINE returns NULL\n");
-     res = -1;
-   } else {
-     res = strlen((char*)(FTH.mem+addr));
-     if(*((char*)(FTH.mem+addr)+res-1)=='\n') res--; 
-     //CONWriteString("READ-LINE returns string length %d\n",res);
-     SWAP();
+   res = FIOReadLine(fp,(char*)(FTH.mem+addr),len);
+   if (res == len-1 && *((char*)(FTH.mem+addr)+res-1)!='\n') {   /* Longer than u1, so the last one is read again next time */
+     res--;
+     FIOGetSetPosition(fp,FIOGetSetPosition(fp,-1)-1);
    }
+   if (res > 0 && *((char*)(FTH.mem+addr)+res-1)=='\n') res--;
+   SWAP();
    if(res<0) {
      res=0;
      CELL(FTH.save_sp+4)=0; 
@@ -172,22 +161,21 @@ void FTH_do_os(void)
   case 13: /*delete-file*/ FTH.save_sp+=4;len=CELL(FTH.save_sp-4);addr=CELL(FTH.save_sp);
     CLIP(); SWAP(); if(!make_name((char*)(FTH.mem+addr),len)) {ior=-202;
       SWAP(); goto end;} SWAP(); FIODeleteFile(FTH.filename); goto end;
-#if 0			 
- case 14: /*reposition-file*/ save_sp+=8;FILEID(CELL(FTH.save_sp-8)); 
-                          fseek(fp,CELL(FTH.save_sp),SEEK_SET);goto end;
+ case 14: /*reposition-file*/ FTH.save_sp+=8;FILEID(CELL(FTH.save_sp-8));
+                          if (CELL(FTH.save_sp-4)!=0 || (CELL(FTH.save_sp) & 0x80000000) ||
+                              FIOGetSetPosition(fp,CELL(FTH.save_sp))<0) ior=-200;
+                          goto end;
   
- case 15: /*file-position*/ save_sp-=8;FILEID(CELL(FTH.save_sp+8));
-                          CELL(FTH.save_sp+8)=ftell(fp);CELL(FTH.save_sp+4)=0;
+ case 15: /*file-position*/ FTH.save_sp-=8;FILEID(CELL(FTH.save_sp+8));
+                          res=FIOGetSetPosition(fp,-1);
+                          if (res<0) {res=0;ior=-200;}
+                          CELL(FTH.save_sp+8)=res;CELL(FTH.save_sp+4)=0;
                           goto end;
- case 17: /* file-size*/ save_sp-=8;FILEID(CELL(FTH.save_sp+8));
-                          {long oldpos;
-                           oldpos=ftell(fp); 
-                           fseek(fp,0L,SEEK_END);
-                           CELL(FTH.save_sp+8)=ftell(fp);CELL(FTH.save_sp+4)=0;
-                           fseek(fp,oldpos,SEEK_SET);
-                          }
+ case 17: /* file-size*/ FTH.save_sp-=8;FILEID(CELL(FTH.save_sp+8));
+                          res=FIOFileSize(fp); /* Kept by FIO, no seeking */
+                          if (res<0) {res=0;ior=-200;}
+                          CELL(FTH.save_sp+8)=res;CELL(FTH.save_sp+4)=0;
                           goto end;
-#endif			  
  case 18: /* cmd-filename */
                          FTH.save_sp+=4;len=CELL(FTH.save_sp-4);addr=CELL(FTH.save_sp);
 			 CLIP(); SWAP(); ior=get_cmd_file_name(addr,len);  SWAP();
@@ -195,6 +183,19 @@ void FTH_do_os(void)
  case 19: /* keycode? */
                          CELL(FTH.save_sp) = keypressed(CELL(FTH.save_sp));
                          return;
+ case 20: /* block */ case 21: /* buffer */ case 22: /* update */
+ case 23: /* save-buffers */ case 24: /* empty-buffers */ case 25: /* block-stats */
+ case 27: /* pin-block */ case 28: /* unpin-block */
+                         /* ( x area n --- x' ior ), area and n are the buffers */
+                         FTH.save_sp+=4;
+                         ior=FTH_block_os(code,CELL(FTH.save_sp),CELL(FTH.save_sp-4),
+                                          &CELL(FTH.save_sp+4));
+                         goto end;
+ case 26: /* block-file */
+                         FTH.save_sp+=4;len=CELL(FTH.save_sp-4);addr=CELL(FTH.save_sp);
+                         CLIP(); SWAP(); if(!make_name((char*)(FTH.mem+addr),len)) {ior=-202;
+                           SWAP(); goto end;} SWAP(); ior=FTH_block_file(FTH.filename);
+                         goto end;
  } return;
  end: CELL(FTH.save_sp)=ior;
 }
@@ -53,9 +53,18 @@ static void CMDReadLine(char *buffer,int maxSize) {
 
 /**
  * @brief      Run the main program
+ *
+ * @param      command  Command to run directly, NULL for interactive CLI
+ *
+ * @return     Exit status, 0 if ok, 1 if command not recognised
  */
-void ApplicationRun(void) {
+int ApplicationRun(char *command) {
     char inputLine[64];
+    if (command != NULL) {                                                          // Run command directly if provided
+        if (CMDExecute(command)) return 0;
+        VDUWriteString("Bad command\r\n");
+        return 1;
+    }
     while (SYSAppRunning()) {
         VDUWrite(42);VDUWrite(32);
         CMDReadLine(inputLine,sizeof(inputLine)-1);
@@ -63,6 +72,7 @@ void ApplicationRun(void) {
             VDUWriteString("Bad command\r\n");
         }
     }
+    return 0;
 }
 
 /**
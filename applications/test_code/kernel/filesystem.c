@@ -70,8 +70,8 @@ void DemoApp_CheckFileIO(void) {
 	//          Directory listing.
 	//
 	CONWriteString("\r\nFSYSOpenDirectory\r\n");
-	e = FSYSOpenDirectory("/");CONWriteString(" %d",e);
-	while (e = FSYSReadDirectory(buffer),e == 0) CONWriteString(" %s",buffer);
+	e = FSYSOpenDirectory(0,"/");CONWriteString(" %d",e);
+	while (e = FSYSReadDirectory(0,&fi),e == 0) CONWriteString(" %s:%d",fi.name,fi.length);
 	CONWriteString(" %d",e);
-	e = FSYSCloseDirectory();CONWriteString(" %d",e);
+	e = FSYSCloseDirectory(0);CONWriteString(" %d",e);
 }
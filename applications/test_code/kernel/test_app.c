@@ -105,8 +105,12 @@ static void _GraphicsTest4(void) {
 
 /**
  * @brief      Run the main program
+ *
+ * @param      command  Command to run directly (ignored by the test program)
+ *
+ * @return     Exit status
  */
-void ApplicationRun(void) {
+int ApplicationRun(char *command) {
     int n = 0;
     VDUWrite(22);VDUWrite(mode);                                                    // Switch mode
     _GraphicsTest4();
@@ -151,4 +155,5 @@ void ApplicationRun(void) {
             }
         }
     }
+    return 0;
 }
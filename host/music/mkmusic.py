@@ -0,0 +1,89 @@
+#!/bin/env python3
+#
+#		Convert a text song description to the AMUS format played by music.c
+#
+#		mkmusic.py <source> <target>
+#
+#		channels <n>			channels used, 1-4
+#		speed <ticks>			50Hz ticks per row
+#		rows <n>				rows per pattern, 1-64
+#		restart <n>				order list position to loop back to
+#		envelope <n> <T> <PI1> <PI2> <PI3> <PN1> <PN2> <PN3> <AA> <AD> <AS> <AR> <ALA> <ALD>
+#		order <p> <p> ...		patterns to play
+#		pattern <n>				start of pattern n, followed by up to rows lines
+#
+#		Pattern lines have an entry for each channel seperated by | , each of which is
+#		blank (or ---) for nothing, off to silence, or <note> <type> <amplitude> where note
+#		is a name like C4 C#4 Db4 or a pitch 0-254, type is sq no or wt, amplitude -15..0 or 
+#		an envelope 1-16
+#
+import sys,re
+
+notes = { "c":0,"d":2,"e":4,"f":5,"g":7,"a":9,"b":11 }
+types = { "no":0,"sq":1,"wt":3 }
+
+def pitch(s):
+	m = re.match("^([a-g])([#b]?)(\\d)$",s.lower())
+	if m is None:
+		return int(s)
+	semitone = notes[m.group(1)] + { "":0,"#":1,"b":-1 }[m.group(2)] + (int(m.group(3))-4) * 12
+	p = 53 + semitone * 4														# 53 is middle C
+	assert p >= 0 and p < 255,"Note out of range "+s
+	return p
+
+settings = { "channels":4,"speed":6,"rows":64,"restart":0 }
+envelopes = []
+order = []
+patterns = {}
+current = None
+
+for line in open(sys.argv[1]).readlines():
+	line = line.split("#")[0].rstrip()
+	if line.strip() == "":
+		continue
+	words = line.split()
+	if words[0] in settings:
+		settings[words[0]] = int(words[1])
+	elif words[0] == "envelope":
+		envelopes.append([int(x) & 0xFF for x in words[1:15]])
+	elif words[0] == "order":
+		order = [int(x) for x in words[1:]]
+	elif words[0] == "pattern":
+		current = int(words[1])
+		patterns[current] = []
+	else:
+		assert current is not None,"Row outside pattern "+line
+		patterns[current].append(line.split("|"))
+
+pcount = max(patterns.keys())+1
+data = bytearray(b"AMUS")
+data += bytes([1,settings["channels"],settings["speed"],settings["rows"],pcount,len(order),settings["restart"],len(envelopes)])
+for e in envelopes:
+	data += bytes(e)
+data += bytes(order)
+offsetTable = len(data)
+data += bytes(4 * pcount)
+
+for p in range(0,pcount):
+	rows = patterns.get(p,[])
+	assert len(rows) <= settings["rows"],"Too many rows in pattern "+str(p)
+	body = bytearray()
+	for r in range(0,settings["rows"]):
+		cells = rows[r] if r < len(rows) else []
+		mask = 0
+		events = bytearray()
+		for c in range(0,min(len(cells),settings["channels"])):
+			cell = cells[c].strip().split()
+			if len(cell) == 0 or cell[0] == "---":
+				continue
+			mask |= (1 << c)
+			if cell[0] == "off":
+				events += bytes([255,0,0])
+			else:
+				events += bytes([pitch(cell[0]),types[cell[1]],int(cell[2]) & 0xFF])
+		body += bytes([mask]) + events
+	offset = len(data)
+	data[offsetTable+p*4:offsetTable+p*4+4] = offset.to_bytes(4,"little")
+	data += len(body).to_bytes(2,"little") + body
+
+open(sys.argv[2],"wb").write(data)
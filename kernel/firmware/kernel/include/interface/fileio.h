@@ -22,9 +22,21 @@
 #define FIO_ERR_HANDLE      (-5)                                                    // Bad handle / not open
 #define FIO_ERR_READONLY    (-6)                                                    // Writing to read opened file.
 #define FIO_ERR_NOTDIR      (-7)                                                    // Not a directory
+#define FIO_ERR_EOF         (-8)                                                    // Nothing more to read
+#define FIO_ERR_EXISTS      (-9)                                                    // Creating a file that already exists
+#define FIO_ERR_BUSY        (-10)                                                   // Too many requests waiting
 
 #define FIO_EOF             (1)                                                     // End of file / Directory lsit.
 
+//
+//      Ways of opening a file with FIOOpenEx(), each is a single open by the file system.
+//
+#define FIO_OPEN_READWRITE  (0)                                                     // Existing file, read and write
+#define FIO_OPEN_READ       (1)                                                     // Existing file, read only
+#define FIO_OPEN_TRUNCATE   (2)                                                     // Create, or empty an existing file
+#define FIO_OPEN_CREATE_NEW (3)                                                     // Create, error if it exists
+#define FIO_OPEN_APPEND     (4)                                                     // Open or create, at the end
+
 #define MAX_FILENAME_SIZE   (32)                                                    // Max size of filename base
 
 typedef struct _FIO_Information {
@@ -34,6 +46,7 @@ typedef struct _FIO_Information {
 } FIOInfo;
 
 #define FIO_MAX_HANDLES     (8)                                                     // Maximum number of supported files.
+#define FIO_MAX_DIRECTORIES (4)                                                     // Maximum number of directories being read.
 
 //
 //      Do not use these, use the FIO versions instead.
@@ -41,10 +54,13 @@ typedef struct _FIO_Information {
 void    FSYSInitialise(void);
 
 int     FSYSOpen(int handle,char *name);                                            // Open an existing file
+int     FSYSOpenEx(int handle,char *name,int mode);                                 // Open a file in one of the FIO_OPEN modes
 int     FSYSClose(int handle);                                                      // Close an open file.
 int     FSYSRead(int handle,void *data,int size);                                   // Read bytes from a file.
 int     FSYSWrite(int handle,void *data,int size);                                  // Write bytes to a file.
 int     FSYSGetSetPosition(int handle,int newPosition);                             // Read and optionally set position.
+int     FSYSFileSize(int handle);                                                   // Size of an open file.
+int     FSYSPreallocate(int handle,int size);                                       // Allocate space for an empty file.
 
 int     FSYSFileInformation(char *name,FIOInfo *info);                              // Check if file exists/get information.
 int     FSYSCreateFile(char *name);                                                 // Create an empty file of that name.
@@ -52,8 +68,9 @@ int     FSYSCreateDirectory(char *name);
 int     FSYSDeleteFile(char *name);                                                 // Delete a file
 int     FSYSRenameFile(char *oldname, char *newname);                               // Rename a file
 int     FSYSDeleteDirectory(char *name);
+bool    FSYSSetDirectory(char *directory);                                          // Set current directory, true if used
 
-int     FSYSOpenDirectory(char *directory);                                         // Open a directory
-int     FSYSReadDirectory(char *fileName);                                          // Read next directory entry
-int     FSYSCloseDirectory(void);                                                   // Close directory
+int     FSYSOpenDirectory(int handle,char *directory);                              // Open a directory
+int     FSYSReadDirectory(int handle,FIOInfo *info);                                // Read next directory entry
+int     FSYSCloseDirectory(int handle);                                             // Close directory
 
@@ -11,9 +11,9 @@
 
 #pragma once
 //
-//      Main execution
+//      Main execution, command is run directly if not NULL, returns exit status.
 //
-void ApplicationRun(void);
+int ApplicationRun(char *command);
 //
 //      Timer/Interrupt functions.
 //
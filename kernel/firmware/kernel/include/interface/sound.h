@@ -13,4 +13,6 @@
 
 int8_t ApplicationGetChannelSample(int channel);
 int SNDGetSampleFrequency(void);
+void SNDLockMixer(void);
+void SNDUnlockMixer(void);
 
@@ -11,8 +11,9 @@
 
 #pragma once
 
-void SNDInitialise(bool _combineChannels);
+void SNDInitialise(void);
 
 
 #define SAMPLE_DIVIDER (32)                 // Divider, affects the interrupts / second of the PWM sample output. More samples are better but slower.
+#define SND_BLOCK_SIZE (256)                // Samples rendered per DMA block, two blocks are double buffered.
 
@@ -27,4 +27,9 @@
 #include "support/control_codes.h"
 #include "support/fileio.h"
 #include "support/soundsystem.h"
+#include "support/music.h"
 #include "support/vdu.h"
+#include "support/profile.h"
+#include "support/events.h"
+#include "support/hidkeyboard.h"
+#include "support/sectorcache.h"
@@ -0,0 +1,41 @@
+/**
+ * @file       events.h
+ *
+ * @brief      Header file, timestamped input event queue
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#pragma once
+
+#define EVT_QUEUE_SIZE      (128)                                               // Events queued, power of 2
+
+#define EVT_KEY_DOWN        (1)                                                 // code = key code, device = modifiers
+#define EVT_KEY_UP          (2)
+#define EVT_MOUSE_MOVE      (3)                                                 // x,y = position, consecutive moves are merged
+#define EVT_MOUSE_BUTTON    (4)                                                 // code = button bits
+#define EVT_MOUSE_WHEEL     (5)                                                 // y = wheel change
+#define EVT_CONTROLLER      (6)                                                 // device = controller, x,y = direction, code = buttons
+
+#define EVT_BUTTON_A        (0x01)                                              // Controller button bits
+#define EVT_BUTTON_B        (0x02)
+#define EVT_BUTTON_X        (0x04)
+#define EVT_BUTTON_Y        (0x08)
+
+typedef struct _input_event {
+    uint32_t time;                                                              // TMRReadTimeMS() when it happened
+    uint8_t  type;
+    uint8_t  device;
+    uint16_t code;
+    int16_t  x,y;
+} EVTEvent;
+
+void EVTRecord(int type,int device,int code,int x,int y);
+void EVTControllerState(int n,CTLState *cs);
+int  EVTReadEvents(EVTEvent *events,int maxEvents);
+int  EVTPending(void);
+uint32_t EVTGetOverflowCount(void);
+void EVTFlush(void);
@@ -14,10 +14,22 @@
 void FIOInitialise(void);
 
 int FIOOpen(char *fileName);
+int FIOOpenEx(char *fileName,int mode);
 int FIOClose(int handle);
 int FIORead(int handle,void *data,int size); 
 int FIOWrite(int handle,void *data,int size);
 int FIOGetSetPosition(int handle,int newPosition); 
+int FIOFileSize(int handle);
+
+int FIOSetBuffer(int handle,void *buffer,int size);
+int FIOFlush(int handle);
+int FIOReadByte(int handle);
+int FIOWriteByte(int handle,int byte);
+int FIOReadLine(int handle,char *line,int size);
+
+int FIOLoadFile(char *fileName,void *data,int maxSize);
+int FIOSaveFile(char *fileName,void *data,int size);
+int FIOSaveFile2(char *fileName,void *data1,int size1,void *data2,int size2);
 
 int FIOCreateFile(char *fileName);
 int FIOCreateDirectory(char *fileName);
@@ -29,8 +41,25 @@ int FIOChangeDirectory(char *directory);
 
 int FIOOpenDirectory(char *directory);          
 int FIOReadDirectory(int handle,char *fileName); 
+int FIOReadDirectoryEx(int handle,FIOInfo *info);
 int FIOCloseDirectory(int handle); 
 
+#define FIO_ASYNC_REQUESTS  (8)                                                     // Requests at once, power of 2
+#define FIO_ASYNC_CHUNK     (4096)                                                  // Bytes transferred at each step
+#define FIO_ASYNC_TICK_CHUNKS (4)                                                   // Most steps from SYSYield() each 50Hz tick
+
+typedef void (*FIOASYNCCALLBACK)(int request,int result,void *context);
+
+int FIOReadAsync(int handle,void *data,int size,FIOASYNCCALLBACK callback,void *context);
+int FIOWriteAsync(int handle,void *data,int size,FIOASYNCCALLBACK callback,void *context);
+bool FIOAsyncIsComplete(int request,int *pResult);
+int FIOAsyncWait(int request);
+int FIOAsyncPending(void);
+bool FIOAsyncStep(void);
+void FIOAsyncTick(void);
+void FIOAsyncReset(void);
+void FIOAsyncSetWorker(bool isWorker);
+
 char *FIOMapFileName(char *fileName);
 char *FIOGetCWD(void);
 int FIOChangeCWD(char *d);
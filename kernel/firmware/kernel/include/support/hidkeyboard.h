@@ -0,0 +1,23 @@
+/**
+ * @file       hidkeyboard.h
+ *
+ * @brief      Header file, USB HID keyboard report decoding
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#pragma once
+
+#define HID_BOOT_REPORT_SIZE    (8)                                             // Modifiers, reserved, 6 keys
+#define HID_BOOT_KEYS           (6)
+#define HID_BITMAP_BYTES        (32)                                            // Largest NKRO bitmap, 256 keys
+#define HID_MAX_ARRAY_KEYS      (16)                                            // Most key codes used from a key array
+
+typedef void (*HIDKEYHANDLER)(uint8_t isDown,uint8_t keyCode,uint8_t modifiers);
+
+void HIDKeyboardReset(void);
+bool HIDKeyboardSetDescriptor(uint8_t const *desc,int len,HIDKEYHANDLER handler);
+bool HIDKeyboardReport(uint8_t const *report,int len,HIDKEYHANDLER handler);
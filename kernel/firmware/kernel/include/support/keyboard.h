@@ -18,6 +18,9 @@ void KBDReceiveEvent(uint8_t isDown,uint8_t keyCode,uint8_t modifiers);
 void KBDCheckTimer(void);
 int KBDGetModifiers(void);
 void KBDInsertQueue(int ascii);
+int KBDInsertQueueBulk(const char *text,int count);
+int KBDQueueFree(void);
+uint32_t KBDGetOverflowCount(void);
 int KBDIsKeyAvailable(void);
 uint8_t *KBDGetStateArray(void);
 int KBDGetKey(void);
@@ -0,0 +1,18 @@
+/**
+ * @file       music.h
+ *
+ * @brief      Header file, tracker style music player
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#pragma once
+
+int  MUSLoad(char *fileName);
+int  MUSPlay(bool loop);
+void MUSStop(void);
+bool MUSIsPlaying(void);
+void MUSTick(void);
@@ -0,0 +1,42 @@
+/**
+ * @file       profile.h
+ *
+ * @brief      Header file, profiling counters. These are only maintained on
+ *             the simulator, on the hardware they compile to nothing.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#pragma once
+
+#define PRF_VDU_BYTES       (0)                                                 // Bytes sent to VDUWrite()
+#define PRF_PLOT_COMMANDS   (1)                                                 // PLOT commands executed
+#define PRF_TEXT_CHARS      (2)                                                 // Characters rendered
+#define PRF_FORTH_OPS       (3)                                                 // Forth VM instructions
+#define PRF_AUDIO_UNDERRUNS (4)                                                 // Streamed sound not read in time
+#define PRF_RENDER_TIME     (5)                                                 // Time converting framebuffer (us)
+#define PRF_PIXEL_WRITES    (6)                                                 // Pixels written to the bitplanes, not spans
+#define PRF_SPAN_BYTES      (7)                                                 // Whole bytes written by horizontal spans
+#define PRF_GLYPH_BYTES     (8)                                                 // Bitplane bytes written rendering characters
+#define PRF_SCROLL_BYTES    (9)                                                 // Bytes copied scrolling text
+#define PRF_FLOAT_OPS       (10)                                                // Floating point operations (software on the M0+)
+
+#define PRF_COUNTERS        (11)                                                // Number of counters
+
+#define PRF_WRITE_MAP_SIZE  (640*480/8)                                         // Byte positions tracked by the write map
+
+#ifdef PICO
+#define PRFCount(c,n)       ((void)0)
+#define PRFMarkWrite(o,n)   ((void)0)
+#else
+extern uint32_t prfCounters[PRF_COUNTERS];
+#define PRFCount(c,n)       ((void)(prfCounters[c] += (n)))
+#define PRFMarkWrite(o,n)   PRFMarkWriteRange(o,n)
+void PRFMarkWriteRange(int offset,int count);
+uint8_t *PRFGetWriteMap(void);
+#endif
+
+uint32_t PRFReadCounter(int counter);
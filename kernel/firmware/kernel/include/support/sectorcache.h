@@ -0,0 +1,54 @@
+/**
+ * @file       sectorcache.h
+ *
+ * @brief      Header file, storage sector cache
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#pragma once
+
+#define SEC_SECTOR_SIZE         (512)                                           // Bytes per sector
+
+#ifndef ARTURO_SEC_CACHE_SECTORS                                                // Sectors kept in the cache, set in config.make
+#define ARTURO_SEC_CACHE_SECTORS (16)
+#endif
+
+#ifndef ARTURO_SEC_TRANSFER_SECTORS                                             // Most sectors read ahead or written together, set in config.make
+#define ARTURO_SEC_TRANSFER_SECTORS (8)
+#endif
+
+#define SEC_CACHE_SECTORS       (ARTURO_SEC_CACHE_SECTORS)
+#define SEC_TRANSFER_SECTORS    (ARTURO_SEC_TRANSFER_SECTORS)
+
+#if SEC_TRANSFER_SECTORS < 1 || SEC_TRANSFER_SECTORS > SEC_CACHE_SECTORS
+#error "ARTURO_SEC_TRANSFER_SECTORS must be from 1 to ARTURO_SEC_CACHE_SECTORS"
+#endif
+
+//
+//      The device starts a transfer, which may still be running when it returns, and waits for
+//      the last transfer to finish. Both return 0 or an error code. It also gives the number of
+//      sectors on a drive, so reading ahead stops at the end.
+//
+typedef int (*SECTRANSFER)(uint8_t drive,uint32_t sector,uint8_t *buffer,int count,bool isWrite);
+typedef int (*SECWAIT)(uint8_t drive);
+typedef uint32_t (*SECSIZE)(uint8_t drive);
+
+typedef struct _sec_statistics {
+    uint32_t hits,misses;                                                       // Single sector reads found, or not, in the cache
+    uint32_t readTransfers,sectorsRead;                                         // Reads from the device
+    uint32_t writeTransfers,sectorsWritten;                                     // Writes to the device
+    uint32_t readAhead;                                                         // Sectors read before they were asked for
+    uint32_t largestTransfer;                                                   // Most sectors in one transfer
+} SECSTATISTICS;
+
+void SECSetDevice(SECTRANSFER transfer,SECWAIT wait,SECSIZE size);
+int  SECRead(uint8_t drive,uint32_t sector,uint8_t *buffer,int count);
+int  SECWrite(uint8_t drive,uint32_t sector,const uint8_t *buffer,int count);
+int  SECSync(uint8_t drive);
+void SECInvalidate(uint8_t drive);
+void SECGetStatistics(SECSTATISTICS *stats);
+void SECResetStatistics(void);
@@ -19,10 +19,47 @@ typedef struct _sound_channel {
 
 #define SNDTYPE_NOISE  	(0)
 #define SNDTYPE_SQUARE  (1)
+#define SNDTYPE_SAMPLE  (2)                                                         // 8 bit PCM sample, see SNDPlaySample()
+#define SNDTYPE_WAVETABLE (3)                                                       // Waveform set by SNDSetWaveform()
 
 int SNDGetChannelCount(void);
 void SNDMuteAllChannels(void);
 int8_t SNDGetChannelSample(int channel);
+void SNDRenderBlock(int8_t *out,int n);
 void SNDUpdate(int channel,SNDCHANNEL *c);
+void SNDPlaySample(int channel,const int8_t *data,int length,int loopStart,int sampleRate,int volume);
+void SNDSetWaveform(int channel,const int8_t *data,int length);
+void SNDAdjustChannel(int channel,int type,int frequency16,int volume);
 
+//
+//      BBC Micro style note queues and envelopes, stepped on the 50Hz tick.
+//
+#define SND_QUEUE_DEPTH     (8)                                                     // Notes queued per channel, power of 2
+#define SND_ENVELOPES       (16)                                                    // Envelopes 1-16
+#define SND_FOREVER         (255)                                                   // Duration which plays until flushed
 
+typedef struct _sound_envelope {
+    uint8_t stepLength;                                                             // Step length in cs, bit 7 set stops pitch repeating
+    int8_t  pitchChange[3];                                                         // Pitch change per step, for each section
+    uint8_t pitchSteps[3];                                                          // Steps in each section
+    int8_t  attack,decay,sustain,release;                                           // Amplitude change per step
+    uint8_t attackLevel,decayLevel;                                                 // Targets for attack and decay, 0-126
+} SNDENVELOPE;
+
+bool SNDQueueNote(int channel,int type,int amplitude,int pitch,int duration,bool flush);
+void SNDDefineEnvelope(int envelope,SNDENVELOPE *e);
+int  SNDQueueFree(int channel);
+bool SNDIsChannelPlaying(int channel);
+void SNDFlushQueues(void);
+void SNDTick(void);
+
+//
+//      Streaming WAV or raw files from the file system, refilled on the 50Hz tick.
+//
+int  SNDStreamOpen(char *fileName,int rawRate,int volume,bool loop);
+int  SNDStreamSeek(int frame);
+void SNDStreamStop(void);
+bool SNDStreamIsPlaying(void);
+uint32_t SNDStreamUnderruns(void);
+void SNDStreamTick(void);
+bool SNDStreamMix(int16_t *mix,int count);
@@ -33,6 +33,8 @@ static int _FSYSMapError(FRESULT r) {
         case FR_NO_FILE:                                                        // File/Path not found
         case FR_NO_PATH:
             err = FIO_ERR_NOTFOUND;break;
+        case FR_EXIST:                                                          // Already exists
+            err = FIO_ERR_EXISTS;break;
         case FR_INVALID_NAME:                                                   // Input is wrong.
         case FR_INVALID_OBJECT:
         case FR_INVALID_PARAMETER:
@@ -139,7 +141,23 @@ int FSYSDeleteDirectory(char *name) {
 }
 
 /**
- * @brief      Open File in R/W mode, rewind to start
+ * @brief      Set the current directory, so relative names start from there
+ *             and FatFS does not search the path from the root each time.
+ *
+ * @param      directory  The absolute directory
+ *
+ * @return     true if FatFS now resolves relative names itself.
+ */
+bool FSYSSetDirectory(char *directory) {
+    #if FF_FS_RPATH >= 1
+    return f_chdir(directory) == FR_OK;
+    #else
+    return false;
+    #endif
+}
+
+/**
+ * @brief      Open File in R/W mode, at the start
  *
  * @param[in]  handle  The handle to use
  * @param      name    The name of the file.
@@ -147,12 +165,30 @@ int FSYSDeleteDirectory(char *name) {
  * @return     Error code if non-zero
  */
 int FSYSOpen(int handle,char *name) {
-    FRESULT fr = f_open(&files[handle],name,FA_READ|FA_WRITE|FA_OPEN_EXISTING);     // Open read/write
-    if (fr != FR_OK) return _FSYSMapError(fr);                                      // Error occurred of some sort.
-    fr = f_lseek(&files[handle],0);                                                 // Rewind
-    return _FSYSMapError(fr);
+    return FSYSOpenEx(handle,name,FIO_OPEN_READWRITE);
 };
 
+/**
+ * @brief      Open File in one of the FIO_OPEN modes, with a single f_open
+ *
+ * @param[in]  handle  The handle to use
+ * @param      name    The name of the file.
+ * @param[in]  mode    The FIO_OPEN mode
+ *
+ * @return     Error code if non-zero
+ */
+int FSYSOpenEx(int handle,char *name,int mode) {
+    static const BYTE fatfsModes[] = {
+        FA_READ|FA_WRITE|FA_OPEN_EXISTING,                                          // FIO_OPEN_READWRITE
+        FA_READ|FA_OPEN_EXISTING,                                                   // FIO_OPEN_READ, no write work when closing
+        FA_READ|FA_WRITE|FA_CREATE_ALWAYS,                                          // FIO_OPEN_TRUNCATE
+        FA_READ|FA_WRITE|FA_CREATE_NEW,                                             // FIO_OPEN_CREATE_NEW
+        FA_READ|FA_WRITE|FA_OPEN_APPEND                                             // FIO_OPEN_APPEND
+    };
+    if (mode < 0 || mode >= (int)sizeof(fatfsModes)) return FIO_ERR_COMMAND;
+    return _FSYSMapError(f_open(&files[handle],name,fatfsModes[mode]));             // Opened at the start, or the end if appending
+}
+
 /**
  * @brief      Close the file
  *
@@ -229,34 +265,70 @@ int FSYSGetSetPosition(int handle,int newPosition) {
     return current;
 }
 
-static DIR currentDirectory;
+/**
+ * @brief      Get the size of an open file
+ *
+ * @param[in]  handle  The handle
+ *
+ * @return     Size in bytes
+ */
+int FSYSFileSize(int handle) {
+    return f_size(&files[handle]);                                                  // Kept in the FIL, no disk access
+}
+
+/**
+ * @brief      Allocate contiguous space for an empty file that is about to be
+ *             written, so it can be written in large transfers without
+ *             searching the FAT as it grows. The file is this size
+ *             afterwards.
+ *
+ * @param[in]  handle  The handle
+ * @param[in]  size    The size in bytes
+ *
+ * @return     Error code if non-zero, which is not serious, the file just
+ *             grows as it is written.
+ */
+int FSYSPreallocate(int handle,int size) {
+    #if FF_USE_EXPAND
+    return _FSYSMapError(f_expand(&files[handle],size,1));
+    #else
+    return FIO_OK;
+    #endif
+}
+
+static DIR directories[FIO_MAX_DIRECTORIES];                                        // Directories being read.
 
 /**
  * @brief      Opens directory to be read
  *
+ * @param[in]  handle     The directory handle to use
  * @param      directory  The directory to be read
  *
  * @return     Error code if non-zero
  */
-int FSYSOpenDirectory(char *directory) {
-    return _FSYSMapError(f_opendir(&currentDirectory,directory));                   // Open directory
+int FSYSOpenDirectory(int handle,char *directory) {
+    return _FSYSMapError(f_opendir(&directories[handle],directory));                // Open directory
 }
 
 
 /**
- * @brief      Read next directory entry
+ * @brief      Read next directory entry, with its size and type, which
+ *             f_readdir() has already found, so no f_stat() is needed.
  *
- * @param      fileName  The file name read from the directory
+ * @param[in]  handle  The directory handle
+ * @param      info    Information about the entry
  *
- * @return     Error code if non-zero
+ * @return     Error code if non-zero, FIO_EOF at the end.
  */
-int FSYSReadDirectory(char *fileName) {
+int FSYSReadDirectory(int handle,FIOInfo *info) {
     FILINFO fi;
-    FRESULT fr = f_readdir(&currentDirectory,&fi);                                  // Read next
+    FRESULT fr = f_readdir(&directories[handle],&fi);                               // Read next
     if (fr != FR_OK) return _FSYSMapError(fr);                                      // Error
     if (fi.fname[0] == '\0') return FIO_EOF;                                        // End of directory data.
     fi.fname[MAX_FILENAME_SIZE] = '\0';                                             // Truncate file name.
-    strcpy(fileName,fi.fname);
+    strcpy(info->name,fi.fname);
+    info->isDirectory = (fi.fattrib & AM_DIR) != 0;                                 // Directory flag
+    info->length = info->isDirectory ? 0 : fi.fsize;                                // Length if file, 0 for directory.
     return FIO_OK;
 }
 
@@ -264,8 +336,10 @@ int FSYSReadDirectory(char *fileName) {
 /**
  * @brief      Close directory being read
  *
+ * @param[in]  handle  The directory handle
+ *
  * @return     Error code if non-zero
  */
-int FSYSCloseDirectory(void) {
-    return _FSYSMapError(f_closedir(&currentDirectory));
+int FSYSCloseDirectory(int handle) {
+    return _FSYSMapError(f_closedir(&directories[handle]));
 }
@@ -98,7 +98,11 @@ void CTLUpdateController(uint8_t dev_addr,uint8_t instance,uint8_t const *report
     }
     struct _CTL_MessageData msgBlock;
     msgBlock.len = len;msgBlock.report = report;                                    // Construct the message block.
-    CTLSendMessage(CTLM_UPDATE,CTL_HARDWARE_ID(dev_addr,instance),&msgBlock);       // Send it with the update message
+    uint16_t hwid = CTL_HARDWARE_ID(dev_addr,instance);
+    CTLSendMessage(CTLM_UPDATE,hwid,&msgBlock);                                     // Send it with the update message
+    for (int i = 0;i < controllerCount;i++) {                                       // Queue an event if it has changed.
+        if (controllers[i]._hardwareID == hwid) EVTControllerState(i,&controllers[i]);
+    }
 }
 
 
@@ -11,9 +11,13 @@
 
 #include "common.h"
 #include "dvi.h"
+#include "hardware/dma.h"
 
 static int sampleFrequency = -1;
-static bool combineSoundChannels = false;
+
+static uint32_t dmaBuffer[2][SND_BLOCK_SIZE];                                       // Double buffer of PWM compare values
+static int dmaChannel[2];                                                           // DMA channels playing them.
+static bool isPlaying = false;                                                      // DMA interrupt set up.
 
 /**
  * @brief      Returns the sample rate of the underlying hardware
@@ -28,48 +32,76 @@ int SNDGetSampleFrequency(void) {
 }
 
 /**
- * @brief      PWM Interrupt handler
+ * @brief      Fill a block with samples, from the sound system or the
+ *             application
+ *
+ * @param      out   Sample buffer
+ * @param[in]  n     Number of samples
  */
-void pwm_interrupt_handler() {
-    pwm_clear_irq(pwm_gpio_to_slice_num(AUDIO_PIN_L));                              // Acknowledge interrupt
+static void _SNDFillBlock(int8_t *out,int n) {
     #if ARTURO_PROCESS_SOUND==1
-    uint8_t sample0 = SNDGetChannelSample(0)+128;                                   // Get sample 1, copy to Left Pin
+    SNDRenderBlock(out,n);
     #else
-    uint8_t sample0 = ApplicationGetChannelSample(0)+128;                           // Get sample 1, copy to Left Pin
+    for (int i = 0;i < n;i++) out[i] = ApplicationGetChannelSample(0);
     #endif
+}
 
-    pwm_set_gpio_level(AUDIO_PIN_L,sample0);
-    if (AUDIO_HARDWARE_CHANNELS == 2) {                                             // If there are 2 channels.
-        uint8_t sample1 = sample0;
-        if (!combineSoundChannels) {                                                // Reuse sample 1 if combined, otherwise get sample 2
-            #if ARTURO_PROCESS_SOUND==1
-            uint8_t sample1 = SNDGetChannelSample(0)+128;                           // Get sample 1, copy to Left Pin
-            #else
-            uint8_t sample1 = ApplicationGetChannelSample(0)+128;                   // Get sample 1, copy to Left Pin
-            #endif
+/**
+ * @brief      Render a block and convert it to PWM compare values. Both pins
+ *             are on the same PWM slice, so each 32 bit value sets both
+ *             levels.
+ *
+ * @param      buffer  DMA buffer to fill
+ */
+static void _SNDFillDMABuffer(uint32_t *buffer) {
+    int8_t samples[SND_BLOCK_SIZE];
+    _SNDFillBlock(samples,SND_BLOCK_SIZE);
+    for (int i = 0;i < SND_BLOCK_SIZE;i++) {
+        uint32_t level = (uint8_t)(samples[i]+128);
+        buffer[i] = (level << 16) | level;                                          // Same level on both outputs.
+    }
+}
+
+/**
+ * @brief      DMA Interrupt handler, a block has finished so refill it. The
+ *             other channel, chained to this one, is already playing.
+ */
+static void _SNDDMAInterruptHandler(void) {
+    for (int i = 0;i < 2;i++) {
+        if (dma_channel_get_irq1_status(dmaChannel[i])) {
+            dma_channel_acknowledge_irq1(dmaChannel[i]);                            // Acknowledge interrupt
+            _SNDFillDMABuffer(dmaBuffer[i]);                                        // Refill the block just played
+            dma_channel_set_read_addr(dmaChannel[i],dmaBuffer[i],false);            // Rewind, for when it is next chained to.
         }
-        pwm_set_gpio_level(AUDIO_PIN_R,sample1);
     }
 }
 
+/**
+ * @brief      Set up a DMA channel to feed one block to the PWM compare
+ *             register, paced by the PWM wrap, chaining to the other.
+ *
+ * @param[in]  n      Channel index (0,1)
+ * @param[in]  slice  PWM slice
+ */
+static void _SNDInitialiseDMA(int n,int slice) {
+    dma_channel_config c = dma_channel_get_default_config(dmaChannel[n]);
+    channel_config_set_transfer_data_size(&c,DMA_SIZE_32);
+    channel_config_set_read_increment(&c,true);
+    channel_config_set_write_increment(&c,false);
+    channel_config_set_dreq(&c,pwm_get_dreq(slice));                               // One transfer per PWM wrap
+    channel_config_set_chain_to(&c,dmaChannel[1-n]);                               // Then start the other buffer.
+    dma_channel_configure(dmaChannel[n],&c,&pwm_hw->slice[slice].cc,dmaBuffer[n],SND_BLOCK_SIZE,false);
+    dma_channel_set_irq1_enabled(dmaChannel[n],true);
+}
 
 /**
  * @brief      Initialise a Pico PWM channel
  *
  * @param[in]  pin              The pin to use
- * @param[in]  enableInterrupt  Enable interrupts on this pin ?
  */
-static void _SND_Initialise_Channel(int pin,bool enableInterrupt) {
+static void _SND_Initialise_Channel(int pin) {
     gpio_set_function(pin, GPIO_FUNC_PWM);
     int pin_slice = pwm_gpio_to_slice_num(pin);
-    if (enableInterrupt) {                                                          // Only enable interrupt on 1 channel.
-        // Setup PWM interrupt to fire when PWM cycle is complete
-        pwm_clear_irq(pin_slice);
-        // set the handle function above
-        irq_set_exclusive_handler(PWM_IRQ_WRAP, pwm_interrupt_handler);
-        irq_set_enabled(PWM_IRQ_WRAP, true);
-        pwm_set_irq_enabled(pin_slice, true);
-    }
     // Setup PWM for audio output
     pwm_config config = pwm_get_default_config();
     pwm_config_set_clkdiv(&config, SAMPLE_DIVIDER);
@@ -80,15 +112,37 @@ static void _SND_Initialise_Channel(int pin,bool enableInterrupt) {
 }
 
 /**
- * @brief      Initialise the whole sound system
- *
- * @param[in]  _combineChannels  Play 2 channels as one.
+ * @brief      Initialise the whole sound system. Both outputs play the same
+ *             sample.
  */
-void SNDInitialise(bool _combineChannels) {
-    combineSoundChannels = _combineChannels;                                        // Record if we are supposed to add them.
-    _SND_Initialise_Channel(AUDIO_PIN_L,true);                                      // Initialise 1 or 2 channels.
+void SNDInitialise(void) {
+    _SND_Initialise_Channel(AUDIO_PIN_L);                                           // Initialise 1 or 2 channels.
     if (AUDIO_HARDWARE_CHANNELS == 2) {
-        _SND_Initialise_Channel(AUDIO_PIN_R,false);
+        _SND_Initialise_Channel(AUDIO_PIN_R);
+    }
+    int slice = pwm_gpio_to_slice_num(AUDIO_PIN_L);
+    for (int i = 0;i < 2;i++) {                                                     // Prime both buffers
+        dmaChannel[i] = dma_claim_unused_channel(true);
+        _SNDFillDMABuffer(dmaBuffer[i]);
     }
+    _SNDInitialiseDMA(0,slice);_SNDInitialiseDMA(1,slice);
+    irq_set_exclusive_handler(DMA_IRQ_1,_SNDDMAInterruptHandler);                   // DMA_IRQ_0 is used by the DVI driver.
+    irq_set_enabled(DMA_IRQ_1,true);
+    isPlaying = true;
+    dma_channel_start(dmaChannel[0]);                                               // And start playing.
+}
+
+/**
+ * @brief      Hold off the mixer while a channel is changed, by masking the
+ *             DMA interrupt. The other buffer keeps playing meanwhile.
+ */
+void SNDLockMixer(void) {
+    if (isPlaying) irq_set_enabled(DMA_IRQ_1,false);
 }
 
+/**
+ * @brief      Let the mixer run again
+ */
+void SNDUnlockMixer(void) {
+    if (isPlaying) irq_set_enabled(DMA_IRQ_1,true);
+}
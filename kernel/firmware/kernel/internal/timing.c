@@ -74,9 +74,13 @@ bool SYSAppRunning(void) {
  * @return     true if 50Hz tick occurred.
  */
 bool SYSYield(void) {
+    FIOAsyncTick();                                                             // Progress file requests
     if (tick50HzHasFired) {                                                     // Tick set ?
         tick50HzHasFired = false;
         KBDCheckTimer();                                                        // Check for keyboard repeat
+        MUSTick();                                                              // Advance any music
+        SNDTick();                                                              // Play queued notes
+        SNDStreamTick();                                                        // Refill any sound being streamed
         USBUpdate();                                                            // Update USB system.
         return -1;
     }
@@ -14,7 +14,16 @@
 
 static void usbResetSystem(void);
 
-static short lastReport[KBD_MAX_KEYCODE] = { 0 };                               // state at last HID report.
+/**
+ * @brief      Pass a key event from the report decoder on
+ *
+ * @param[in]  isDown     true if pressed
+ * @param[in]  keyCode    The key code
+ * @param[in]  modifiers  The modifiers
+ */
+static void usbKeyboardEvent(uint8_t isDown,uint8_t keyCode,uint8_t modifiers) {
+    USBKeyboardEvent(isDown,keyCode,modifiers);
+}
 
 /**
  * @brief      Process USB HID Keyboard Report
@@ -22,32 +31,11 @@ static short lastReport[KBD_MAX_KEYCODE] = { 0 };
  *             This converts it to a series of up/down key events
  *
  * @param      report  The USB HID report
+ * @param[in]  len     The Report length
  */
-static void usbProcessReport(uint8_t const *report) {
-
-    for (int i = 0;i < KBD_MAX_KEYCODE;i++) lastReport[i] = -lastReport[i];     // So if -ve was present last time.
-    for (int i = 2;i < 8;i++) {                                                 // Scan the key press array.
-        uint8_t key = report[i];
-        if (key >= KEY_KP1 && key < KEY_KP1+10) {                               // Numeric keypad numbers will work.
-            key = key - KEY_KP1 + KEY_1;
-        }
-        // if (key == KEY_102ND) key = KEY_BACKSLASH;                           // Non US /| mapped.
-
-        if ((report[0] & REBOOT_KEYS) == REBOOT_KEYS) {                         // Ctrl+Alt+AltGr
-            usbResetSystem();
-        }
-
-        if (key != 0 && key < KBD_MAX_KEYCODE) {                                // If key is down, and not too high.
-            if (lastReport[key] == 0) USBKeyboardEvent(1,key,report[0]);        // It wasn't down before so key press.
-            lastReport[key] = 1;                                                // Flag it as now being down.
-        }
-    }
-
-    for (int i = 0;i < KBD_MAX_KEYCODE;i++) {                                   // Any remaining -ve keys are up actions.
-        if (lastReport[i] < 0) {
-            USBKeyboardEvent(0,i,0);                                            // Flag going up.
-            lastReport[i] = 0;                                                  // Mark as now up
-        }
+static void usbProcessReport(uint8_t const *report,uint16_t len) {
+    if (HIDKeyboardReport(report,len,usbKeyboardEvent)) {                       // Ctrl+Alt+AltGr
+        usbResetSystem();
     }
 }
 
@@ -85,7 +73,10 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* desc_re
 
     switch(tuh_hid_interface_protocol(dev_addr, instance)) {
 
-    case HID_ITF_PROTOCOL_KEYBOARD:
+    case HID_ITF_PROTOCOL_KEYBOARD:                                             // Mounted in boot protocol, switch to report
+        if (HIDKeyboardSetDescriptor(desc_report,desc_len,usbKeyboardEvent)) {  // protocol if the descriptor is understood.
+            tuh_hid_set_protocol(dev_addr,instance,HID_PROTOCOL_REPORT);
+        }
         break;
 
     case HID_ITF_PROTOCOL_MOUSE:
@@ -100,6 +91,19 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* desc_re
     tuh_hid_receive_report(dev_addr, instance);
 }
 
+/**
+ * @brief      Protocol change completed
+ *
+ * @param[in]  dev_addr  The dev address
+ * @param[in]  instance  The instance
+ * @param[in]  protocol  The protocol now in use
+ */
+void tuh_hid_set_protocol_complete_cb(uint8_t dev_addr, uint8_t instance, uint8_t protocol) {
+    if (tuh_hid_interface_protocol(dev_addr, instance) == HID_ITF_PROTOCOL_KEYBOARD && protocol != HID_PROTOCOL_REPORT) {
+        HIDKeyboardSetDescriptor(NULL,0,usbKeyboardEvent);                      // Not changed, still boot reports.
+    }
+}
+
 /**
  * @brief      USB unmount call back
  *
@@ -121,7 +125,7 @@ void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t cons
 
     switch(tuh_hid_interface_protocol(dev_addr, instance)) {
     case HID_ITF_PROTOCOL_KEYBOARD:
-        usbProcessReport(report);
+        usbProcessReport(report,len);
         break;
 
     case HID_ITF_PROTOCOL_MOUSE:
@@ -139,7 +143,7 @@ void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t cons
  * @brief      Any initialisation not done by tinyUSB
  */
 void USBInitialise(void) {
-    for (int i = 0;i < KBD_MAX_KEYCODE;i++) lastReport[i] = 0;                  // No keys currently known
+    HIDKeyboardReset();                                                         // No keys currently known
     tusb_init();                                                                // Set up tinyUSB
 }
 
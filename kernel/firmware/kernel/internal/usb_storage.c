@@ -1,7 +1,8 @@
 /**
  * @file       usb_storage.c
  *
- * @brief      USB MSC Storage / FATFS link from Apple/Oric emulators.
+ * @brief      USB MSC Storage / FATFS link from Apple/Oric emulators. Sector
+ *             access goes through the sector cache (sectorcache.c).
  *
  * @author     Veselin Sladkov & Paul Robson
  *
@@ -15,6 +16,7 @@
 
 static FATFS msc_fatfs_volumes[CFG_TUH_DEVICE_MAX];
 static volatile bool msc_volume_busy[CFG_TUH_DEVICE_MAX];
+static volatile uint8_t msc_volume_status[CFG_TUH_DEVICE_MAX];                      // CSW status of the last transfer
 static scsi_inquiry_resp_t msc_inquiry_resp;
 bool msc_inquiry_complete = false;
 
@@ -64,6 +66,7 @@ bool inquiry_complete_cb(uint8_t dev_addr, tuh_msc_complete_data_t const *cb_dat
         f_chdrive(drive_path);
         f_chdir("/");
     }
+    if (FIOChangeCWD(FIOGetCWD()) != 0) FIOChangeCWD("/");                          // FatFS starts at the root, so set it again.
 
     msc_inquiry_complete = true;
 
@@ -78,6 +81,7 @@ bool inquiry_complete_cb(uint8_t dev_addr, tuh_msc_complete_data_t const *cb_dat
  */
 void tuh_msc_mount_cb(uint8_t dev_addr) {
     uint8_t const lun = 0;
+    SECInvalidate(dev_addr);                                                        // Nothing cached from a previous key.
     //CONWriteString("MSC mounted, inquiring\r\n");
     tuh_msc_inquiry(dev_addr, lun, &msc_inquiry_resp, inquiry_complete_cb, 0);
 }
@@ -90,6 +94,7 @@ void tuh_msc_mount_cb(uint8_t dev_addr) {
 void tuh_msc_umount_cb(uint8_t dev_addr) {
     char drive_path[3] = "0:";
     drive_path[0] += dev_addr;
+    SECInvalidate(dev_addr);                                                        // Too late to write anything.
     f_unmount(drive_path);
 }
 
@@ -106,7 +111,7 @@ static void wait_for_disk_io(BYTE pdrv) {
 }
 
 /**
- * @brief      Check if disk finished
+ * @brief      Check if disk finished, keeping the transfer's status
  *
  * @param[in]  dev_addr  The dev address
  * @param      cb_data   The cb data
@@ -114,11 +119,57 @@ static void wait_for_disk_io(BYTE pdrv) {
  * @return     True if finished
  */
 static bool disk_io_complete(uint8_t dev_addr, tuh_msc_complete_data_t const *cb_data) {
-    (void)cb_data;
+    msc_volume_status[dev_addr] = cb_data->csw->status;
     msc_volume_busy[dev_addr] = false;
     return true;
 }
 
+/**
+ * @brief      Start a transfer for the sector cache, which does not wait for it
+ *             to finish.
+ *
+ * @param[in]  dev_addr  The dev address
+ * @param[in]  sector    First sector
+ * @param      buffer    The data
+ * @param[in]  count     Number of sectors
+ * @param[in]  isWrite   true to write
+ *
+ * @return     0 or error code
+ */
+static int usb_transfer(uint8_t dev_addr, uint32_t sector, uint8_t *buffer, int count, bool isWrite) {
+    uint8_t const lun = 0;
+    msc_volume_status[dev_addr] = MSC_CSW_STATUS_FAILED;                            // Until it completes.
+    msc_volume_busy[dev_addr] = true;
+    bool ok = isWrite ? tuh_msc_write10(dev_addr, lun, buffer, sector, (uint16_t)count, disk_io_complete, 0)
+                      : tuh_msc_read10(dev_addr, lun, buffer, sector, (uint16_t)count, disk_io_complete, 0);
+    if (!ok) msc_volume_busy[dev_addr] = false;
+    return ok ? 0 : FIO_ERR_SYSTEM;
+}
+
+/**
+ * @brief      Wait for the cache's transfer to finish
+ *
+ * @param[in]  dev_addr  The dev address
+ *
+ * @return     0 or error code, if the device did not complete the command.
+ */
+static int usb_wait(uint8_t dev_addr) {
+    wait_for_disk_io(dev_addr);
+    if (!tuh_msc_mounted(dev_addr)) return FIO_ERR_SYSTEM;
+    return (msc_volume_status[dev_addr] == MSC_CSW_STATUS_PASSED) ? 0 : FIO_ERR_SYSTEM;
+}
+
+/**
+ * @brief      Get the number of sectors on the device, for the cache
+ *
+ * @param[in]  dev_addr  The dev address
+ *
+ * @return     Number of sectors
+ */
+static uint32_t usb_size(uint8_t dev_addr) {
+    return tuh_msc_get_block_count(dev_addr, 0);
+}
+
 /**
  * @brief      Get Disk status
  *
@@ -139,7 +190,7 @@ DSTATUS disk_status(BYTE pdrv) {
  * @return     DSTATUS object
  */
 DSTATUS disk_initialize(BYTE pdrv) {
-    (void)(pdrv);
+    SECSetDevice(usb_transfer, usb_wait, usb_size);                                 // Disk access goes through the cache
     return 0;
 }
 
@@ -154,12 +205,7 @@ DSTATUS disk_initialize(BYTE pdrv) {
  * @return     DRESULT object
  */
 DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
-    uint8_t const dev_addr = pdrv;
-    uint8_t const lun = 0;
-    msc_volume_busy[pdrv] = true;
-    tuh_msc_read10(dev_addr, lun, buff, sector, (uint16_t)count, disk_io_complete, 0);
-    wait_for_disk_io(pdrv);
-    return RES_OK;
+    return SECRead(pdrv, sector, buff, count) == 0 ? RES_OK : RES_ERROR;
 }
 
 /**
@@ -173,12 +219,7 @@ DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
  * @return     DRESULT object
  */
 DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
-    uint8_t const dev_addr = pdrv;
-    uint8_t const lun = 0;
-    msc_volume_busy[pdrv] = true;
-    tuh_msc_write10(dev_addr, lun, buff, sector, (uint16_t)count, disk_io_complete, 0);
-    wait_for_disk_io(pdrv);
-    return RES_OK;
+    return SECWrite(pdrv, sector, buff, count) == 0 ? RES_OK : RES_ERROR;
 }
 
 /**
@@ -194,8 +235,8 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
     uint8_t const dev_addr = pdrv;
     uint8_t const lun = 0;
     switch (cmd) {
-        case CTRL_SYNC:
-            return RES_OK;
+        case CTRL_SYNC:                                                             // Write anything the cache holds
+            return SECSync(pdrv) == 0 ? RES_OK : RES_ERROR;
         case GET_SECTOR_COUNT:
             *((DWORD *)buff) = (WORD)tuh_msc_get_block_count(dev_addr, lun);
             return RES_OK;
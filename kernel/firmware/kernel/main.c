@@ -21,7 +21,7 @@ int main() {
     CONWrite(22);CONWrite(DVI_MODE_640_240_8);                                  // Switch mode.
     HDRDisplay();                                                               // Display header
     CONWriteString("SRAM memory free %dk\r\n",SRAM_AVAILABLE);                  // Display RAM available.
-    SNDInitialise(ARTURO_MONO_SOUND != 0);                                      // Start the sound system, seperate channels according to config.
+    SNDInitialise();                                                            // Start the sound system, both outputs play the same.
     SNDMuteAllChannels();                                                       // Mute all channels
     MSEInitialise();                                                            // Initialise the mouse system
     CTLInitialise();                                                            // Initialise the gamepad system
@@ -32,6 +32,6 @@ int main() {
     FIOInitialise();                                                            // Initialise the file system (core)
     LOCSetLocale(ARTURO_KBD_LOCALE);                                            // Default Locale
     CONWriteString("Booting application...\r\n\r\n");
-    ApplicationRun();                                                           // Run application
+    ApplicationRun(NULL);                                                       // Run application
     while (true) {}
 }
\ No newline at end of file
@@ -11,24 +11,60 @@
 #include "common.h"
 
 static char currentDirectory[128] = { "/" };                                        // The current directory
-static char fileBuffer[sizeof(currentDirectory)+MAX_FILENAME_SIZE];                 // Buffer for result file name
+static char fileBuffer[256];                                                        // Buffer for result file name
+static bool isNativeCWD = false;                                                    // File system resolves relative names itself.
 
 /**
- * @brief      Map simple file name onto CWD if required
+ * @brief      Join a path onto a directory, giving an absolute path with
+ *             ".", ".." and repeated slashes removed.
+ *
+ * @param      out        Buffer for the result
+ * @param[in]  size       Size of the buffer
+ * @param      directory  Absolute directory the path is relative to
+ * @param      path       The path, relative or absolute
+ *
+ * @return     true if it fitted in the buffer.
+ */
+static bool _FIOJoinPath(char *out,int size,char *directory,char *path) {
+    int length = 0;
+    out[0] = '\0';
+    for (int part = (path[0] == '/') ? 1 : 0;part < 2;part++) {                     // Directory (unless absolute), then path
+        char *p = (part == 0) ? directory : path;
+        while (*p != '\0') {
+            while (*p == '/') p++;                                                  // Next element
+            char *start = p;
+            while (*p != '/' && *p != '\0') p++;
+            int n = p-start;
+            if (n == 0 || (n == 1 && start[0] == '.')) continue;                    // Empty or "."
+            if (n == 2 && start[0] == '.' && start[1] == '.') {                     // "..", remove the last element
+                while (length > 0 && out[length-1] != '/') length--;
+                if (length > 0) length--;
+                out[length] = '\0';
+                continue;
+            }
+            if (length+n+2 > size) return false;                                    // Add "/element"
+            out[length++] = '/';
+            memcpy(out+length,start,n);length += n;
+            out[length] = '\0';
+        }
+    }
+    if (length == 0) strcpy(out,"/");                                               // Nothing left, so the root.
+    return true;
+}
+
+/**
+ * @brief      Map simple file name onto CWD if required. If the file system
+ *             keeps its own current directory (FatFS with f_chdir()), the
+ *             name is used as it is, so FatFS starts from the directory
+ *             rather than searching from the root.
  *
  * @param      fileName  file name
  *
- * @return     full path file name.
+ * @return     full path file name, NULL if it is too long.
  */
 char *FIOMapFileName(char *fileName) {
-
-    if (fileName[0] == '/') return fileName;                                        // Path already provided.
-
-    strcpy(fileBuffer,currentDirectory);                                            // Build full filename, adding / if required.
-    if (currentDirectory[strlen(currentDirectory)-1] != '/') {
-        strcat(currentDirectory,"/");
-    }
-    strcat(fileBuffer,fileName);
+    if (isNativeCWD) return fileName;                                               // File system does it.
+    if (!_FIOJoinPath(fileBuffer,sizeof(fileBuffer),currentDirectory,fileName)) return NULL;
     return fileBuffer;
 }
 
@@ -49,28 +85,15 @@ char *FIOGetCWD(void) {
  * @return     non zero if error.
  */
 int FIOChangeCWD(char *d) {
-    if (strcmp(d,".") == 0 || strcmp(d,"") == 0) return 0;                          // . or empty string, no change.
-    if (d[0] == '/') {                                                              // has a /, it's an absolute path
-        strcpy(currentDirectory,d);                                                 // make that the current directory.
-        return 0;
+    char newDir[sizeof(currentDirectory)];
+    if (!_FIOJoinPath(newDir,sizeof(newDir),currentDirectory,d)) return FIO_ERR_COMMAND;
+    if (strcmp(newDir,"/") != 0) {                                                  // The root always exists.
+        FIOInfo info;
+        int e = FSYSFileInformation(newDir,&info);                                  // Try to get information about it.
+        if (e != 0) return e;                                                       // Not found.
+        if (!info.isDirectory) return FIO_ERR_NOTDIR;                               // Wrong type
     }
-    if (strcmp(d,"..") == 0) {                                                      // Up one level.
-        char *lastSlash = currentDirectory;                                         // Find the last slash.
-        char *p = currentDirectory;
-        while (*p != '\0') {
-            if (*p == '/') lastSlash = p;
-            p++;
-        }
-        *lastSlash = '\0';                                                          // Truncate at last slash.
-        if (*currentDirectory == '\0') strcpy(currentDirectory,"/");                // Reached the root ?
-        return 0;
-    }
-
-    char *newDir = FIOMapFileName(d);                                               // Get the new thing switched to.
-    FIOInfo info;
-    int e = FIOFileInformation(newDir,&info);                                       // Try to get information about it.
-    if (e != 0) return e;                                                           // Not found.
-    if (!info.isDirectory) return FIO_ERR_NOTDIR;                                   // Wrong type
+    isNativeCWD = FSYSSetDirectory(newDir);                                         // Tell the file system
     strcpy(currentDirectory,newDir);                                                // Update cwd
     return 0;
 }
@@ -0,0 +1,111 @@
+/**
+ * @file       events.c
+ *
+ * @brief      Timestamped queue of keyboard, mouse and controller events, so
+ *             short presses between polls are not missed, and an
+ *             application can read everything since the last frame at once.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "common.h"
+
+#define EVT_MASK            (EVT_QUEUE_SIZE-1)
+#define EVT_CONTROLLERS     (4)                                                 // Controllers tracked for changes
+
+//
+//      Events are added by the USB, keyboard and mouse code, and removed by the application, both
+//      from the main loop. The adding side only writes eventHead, the removing side only eventTail.
+//
+static EVTEvent queue[EVT_QUEUE_SIZE];
+static volatile uint32_t eventHead = 0,eventTail = 0;
+static uint32_t overflows = 0;
+static bool lastIsMove = false;                                                 // Last event added was a mouse move
+static int controllerState[EVT_CONTROLLERS][3];                                 // Last dx,dy,buttons of each controller
+
+/**
+ * @brief      Record an input event
+ *
+ * @param[in]  type    Event type (EVT_xxx)
+ * @param[in]  device  Device number, or key modifiers
+ * @param[in]  code    Key code or buttons
+ * @param[in]  x       x position or change
+ * @param[in]  y       y position or change
+ */
+void EVTRecord(int type,int device,int code,int x,int y) {
+    uint32_t head = eventHead;
+    uint32_t tail = __atomic_load_n(&eventTail,__ATOMIC_ACQUIRE);
+    if (type == EVT_MOUSE_MOVE && lastIsMove && head-tail >= 2) {               // Merge with an unread move, not the oldest
+        EVTEvent *e = &queue[(head-1) & EVT_MASK];                              // which could be being read.
+        e->time = TMRReadTimeMS();e->x = x;e->y = y;
+        return;
+    }
+    if (head-tail >= EVT_QUEUE_SIZE) {                                          // Full, lose it.
+        overflows++;
+        return;
+    }
+    EVTEvent *e = &queue[head & EVT_MASK];
+    e->time = TMRReadTimeMS();e->type = type;e->device = device;e->code = code;e->x = x;e->y = y;
+    lastIsMove = (type == EVT_MOUSE_MOVE);
+    __atomic_store_n(&eventHead,head+1,__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief      Record a controller event, if its state has changed.
+ *
+ * @param[in]  n     Controller number
+ * @param      cs    Its current state
+ */
+void EVTControllerState(int n,CTLState *cs) {
+    if (n < 0 || n >= EVT_CONTROLLERS || cs == NULL) return;
+    int buttons = (cs->a ? EVT_BUTTON_A:0) | (cs->b ? EVT_BUTTON_B:0) | (cs->x ? EVT_BUTTON_X:0) | (cs->y ? EVT_BUTTON_Y:0);
+    int *last = controllerState[n];
+    if (last[0] != cs->dx || last[1] != cs->dy || last[2] != buttons) {
+        last[0] = cs->dx;last[1] = cs->dy;last[2] = buttons;
+        EVTRecord(EVT_CONTROLLER,n,buttons,cs->dx,cs->dy);
+    }
+}
+
+/**
+ * @brief      Read, and remove, all the events waiting, up to a maximum.
+ *
+ * @param      events     Array to copy them into
+ * @param[in]  maxEvents  Size of the array
+ *
+ * @return     Number of events read.
+ */
+int EVTReadEvents(EVTEvent *events,int maxEvents) {
+    uint32_t tail = eventTail;
+    int count = min(maxEvents,EVTPending());
+    for (int i = 0;i < count;i++) events[i] = queue[(tail+i) & EVT_MASK];
+    __atomic_store_n(&eventTail,tail+count,__ATOMIC_RELEASE);
+    return count;
+}
+
+/**
+ * @brief      Get the number of events waiting
+ *
+ * @return     Number of events
+ */
+int EVTPending(void) {
+    return (int)(__atomic_load_n(&eventHead,__ATOMIC_ACQUIRE)-eventTail);
+}
+
+/**
+ * @brief      Get the number of events lost because the queue was full.
+ *
+ * @return     Overflow count
+ */
+uint32_t EVTGetOverflowCount(void) {
+    return overflows;
+}
+
+/**
+ * @brief      Throw away any waiting events.
+ */
+void EVTFlush(void) {
+    __atomic_store_n(&eventTail,__atomic_load_n(&eventHead,__ATOMIC_ACQUIRE),__ATOMIC_RELEASE);
+}
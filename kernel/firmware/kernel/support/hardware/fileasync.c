@@ -0,0 +1,257 @@
+/**
+ * @file       fileasync.c
+ *
+ * @brief      Asynchronous file reads and writes. Requests are queued and
+ *             carried out a chunk at a time from SYSYield(), or by a worker
+ *             thread on the simulator, so a program does not wait for a
+ *             whole file. FatFS is not asynchronous, so each chunk is an
+ *             ordinary FIORead() or FIOWrite() which blocks until it is
+ *             transferred, and SYSYield() returns that much later. Only
+ *             FIO_ASYNC_TICK_CHUNKS chunks are done each 50Hz tick, leaving
+ *             the rest of the frame to the program.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "common.h"
+
+#define ASYNC_FREE      (0)                                                         // Request states
+#define ASYNC_QUEUED    (1)
+#define ASYNC_DONE      (2)
+
+#define ASYNC_GENERATIONS (0x8000)                                                  // Request numbers are generation * FIO_ASYNC_REQUESTS + slot
+
+struct _AsyncRequest {
+    volatile uint8_t state;                                                         // Free, queued or done.
+    uint16_t generation;                                                            // Advanced each time the slot is used.
+    bool    isWrite;
+    int     handle;
+    uint8_t *data;
+    int     size;                                                                   // Bytes requested
+    int     done;                                                                   // Bytes transferred so far
+    int     result;                                                                 // Bytes transferred or error, when done
+    FIOASYNCCALLBACK callback;                                                      // Called when done, or NULL
+    void    *context;
+};
+
+//
+//      Requests are carried out in order. The queue has a single producer, the program, which adds
+//      slot numbers and advances queueHead, and a single consumer, FIOAsyncStep(), which advances
+//      queueTail when a request is done. A slot is only freed by the program, so the queue can never
+//      hold more than FIO_ASYNC_REQUESTS entries.
+//
+static struct _AsyncRequest requests[FIO_ASYNC_REQUESTS];
+static uint8_t queue[FIO_ASYNC_REQUESTS];
+static volatile uint32_t queueHead = 0,queueTail = 0;
+static bool hasWorker = false;                                                      // Worker thread does the steps.
+static bool inTick = false;                                                         // Stops callbacks re-entering.
+static int tickPeriod = -1;                                                         // 50Hz tick chunks were last done in
+static int tickChunks = 0;                                                          // Chunks done in that tick.
+
+/**
+ * @brief      Reset the request queue, called by FIOInitialise()
+ */
+void FIOAsyncReset(void) {
+    for (int i = 0;i < FIO_ASYNC_REQUESTS;i++) requests[i].state = ASYNC_FREE;
+    queueHead = queueTail = 0;
+}
+
+/**
+ * @brief      Say whether a worker thread calls FIOAsyncStep(), in which case
+ *             FIOAsyncTick() only calls the callbacks.
+ *
+ * @param[in]  isWorker  true if there is a worker
+ */
+void FIOAsyncSetWorker(bool isWorker) {
+    hasWorker = isWorker;
+}
+
+/**
+ * @brief      Get the request number of a slot
+ *
+ * @param[in]  slot  The slot
+ *
+ * @return     Request number
+ */
+static int _FIOAsyncNumber(int slot) {
+    return requests[slot].generation*FIO_ASYNC_REQUESTS+slot;
+}
+
+/**
+ * @brief      Find the request for a request number, which has not been
+ *             freed.
+ *
+ * @param[in]  request  The request number
+ *
+ * @return     The request, NULL if it is not one or has been freed.
+ */
+static struct _AsyncRequest *_FIOAsyncFind(int request) {
+    if (request < 0 || request >= ASYNC_GENERATIONS*FIO_ASYNC_REQUESTS) return NULL;
+    struct _AsyncRequest *r = &requests[request & (FIO_ASYNC_REQUESTS-1)];
+    if (r->state == ASYNC_FREE || r->generation != request / FIO_ASYNC_REQUESTS) return NULL;
+    return r;
+}
+
+/**
+ * @brief      Queue a request
+ *
+ * @param[in]  handle    File handle
+ * @param      data      Data buffer
+ * @param[in]  size      Bytes to transfer
+ * @param[in]  isWrite   true to write
+ * @param[in]  callback  Called from FIOAsyncTick() when done, or NULL to poll
+ * @param      context   Passed to the callback
+ *
+ * @return     Request number, or Error code if negative
+ */
+static int _FIOAsyncQueue(int handle,void *data,int size,bool isWrite,FIOASYNCCALLBACK callback,void *context) {
+    if (size < 0 || data == NULL) return FIO_ERR_COMMAND;
+    int i = 0;
+    while (i < FIO_ASYNC_REQUESTS && requests[i].state != ASYNC_FREE) i++;          // Find a free request
+    if (i == FIO_ASYNC_REQUESTS) return FIO_ERR_BUSY;
+    struct _AsyncRequest *r = &requests[i];
+    r->isWrite = isWrite;r->handle = handle;r->data = data;r->size = size;
+    r->done = 0;r->callback = callback;r->context = context;
+    r->generation = (r->generation+1) % ASYNC_GENERATIONS;                          // A new number, so old ones are not found.
+    r->state = ASYNC_QUEUED;
+    queue[queueHead & (FIO_ASYNC_REQUESTS-1)] = i;
+    __atomic_store_n(&queueHead,queueHead+1,__ATOMIC_RELEASE);                      // Publish it.
+    return _FIOAsyncNumber(i);
+}
+
+/**
+ * @brief      Start reading from a file. The handle and buffer must not be
+ *             used until the request is complete.
+ *
+ * @param[in]  handle    File handle
+ * @param      data      Where to read to
+ * @param[in]  size      Bytes to read
+ * @param[in]  callback  Called from FIOAsyncTick() when done, or NULL to poll
+ *                       with FIOAsyncIsComplete()
+ * @param      context   Passed to the callback
+ *
+ * @return     Request number, or Error code if negative
+ */
+int FIOReadAsync(int handle,void *data,int size,FIOASYNCCALLBACK callback,void *context) {
+    return _FIOAsyncQueue(handle,data,size,false,callback,context);
+}
+
+/**
+ * @brief      Start writing to a file. The handle and buffer must not be
+ *             used until the request is complete.
+ *
+ * @param[in]  handle    File handle
+ * @param      data      Data to write
+ * @param[in]  size      Bytes to write
+ * @param[in]  callback  Called from FIOAsyncTick() when done, or NULL to poll
+ *                       with FIOAsyncIsComplete()
+ * @param      context   Passed to the callback
+ *
+ * @return     Request number, or Error code if negative
+ */
+int FIOWriteAsync(int handle,void *data,int size,FIOASYNCCALLBACK callback,void *context) {
+    return _FIOAsyncQueue(handle,data,size,true,callback,context);
+}
+
+/**
+ * @brief      Check if a request without a callback has finished. Once this
+ *             has returned true the request number is no longer valid.
+ *
+ * @param[in]  request  The request number
+ * @param      pResult  Set to the bytes transferred or an error code, may be
+ *                      NULL
+ *
+ * @return     true if finished.
+ */
+bool FIOAsyncIsComplete(int request,int *pResult) {
+    int result = FIO_ERR_HANDLE;                                                    // Not a request, or finished.
+    struct _AsyncRequest *r = _FIOAsyncFind(request);
+    if (r != NULL) {
+        if (__atomic_load_n(&r->state,__ATOMIC_ACQUIRE) != ASYNC_DONE) return false;
+        result = r->result;
+        r->state = ASYNC_FREE;
+    }
+    if (pResult != NULL) *pResult = result;
+    return true;
+}
+
+/**
+ * @brief      Wait for a request to finish, any callback is not called.
+ *
+ * @param[in]  request  The request number
+ *
+ * @return     Bytes transferred or error code
+ */
+int FIOAsyncWait(int request) {
+    int result;
+    while (!FIOAsyncIsComplete(request,&result)) {
+        if (!hasWorker) FIOAsyncStep();
+    }
+    return result;
+}
+
+/**
+ * @brief      Get the number of requests not yet finished
+ *
+ * @return     Number queued or in progress
+ */
+int FIOAsyncPending(void) {
+    return __atomic_load_n(&queueHead,__ATOMIC_ACQUIRE)-__atomic_load_n(&queueTail,__ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief      Transfer the next chunk of the oldest request. This blocks
+ *             until the chunk has been read or written.
+ *
+ * @return     true if there was anything to do.
+ */
+bool FIOAsyncStep(void) {
+    uint32_t tail = queueTail;
+    if (__atomic_load_n(&queueHead,__ATOMIC_ACQUIRE) == tail) return false;         // Nothing queued.
+    struct _AsyncRequest *r = &requests[queue[tail & (FIO_ASYNC_REQUESTS-1)]];
+    int n = min(FIO_ASYNC_CHUNK,r->size-r->done);
+    int err = FIO_OK;
+    if (r->isWrite) {
+        if (n > 0) err = FIOWrite(r->handle,r->data+r->done,n);
+    } else {
+        err = (n > 0) ? FIORead(r->handle,r->data+r->done,n) : 0;
+        if (err >= 0 && err < n) r->size = r->done+err;                             // End of file
+        if (err >= 0) n = err;
+    }
+    if (err >= 0) r->done += n;
+    if (err < 0 || r->done == r->size) {                                            // Finished, or failed.
+        r->result = (err < 0) ? err : r->done;
+        __atomic_store_n(&r->state,ASYNC_DONE,__ATOMIC_RELEASE);
+        __atomic_store_n(&queueTail,tail+1,__ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+/**
+ * @brief      Called from SYSYield(). Transfers a chunk, unless there is a
+ *             worker or FIO_ASYNC_TICK_CHUNKS have been done this 50Hz
+ *             tick, and calls the callbacks of finished requests.
+ */
+void FIOAsyncTick(void) {
+    if (inTick) return;                                                             // A callback called SYSYield()
+    inTick = true;
+    if (!hasWorker) {
+        int period = TMRReadTimeMS()/20;                                            // Which 50Hz tick it is.
+        if (period != tickPeriod) {
+            tickPeriod = period;tickChunks = 0;
+        }
+        if (tickChunks < FIO_ASYNC_TICK_CHUNKS && FIOAsyncStep()) tickChunks++;
+    }
+    for (int i = 0;i < FIO_ASYNC_REQUESTS;i++) {
+        struct _AsyncRequest *r = &requests[i];
+        if (r->callback != NULL && __atomic_load_n(&r->state,__ATOMIC_ACQUIRE) == ASYNC_DONE) {
+            FIOASYNCCALLBACK callback = r->callback;
+            r->state = ASYNC_FREE;                                                  // Free it first, so it can be reused.
+            (*callback)(_FIOAsyncNumber(i),r->result,r->context);
+        }
+    }
+    inTick = false;
+}
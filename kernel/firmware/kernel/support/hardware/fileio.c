@@ -13,16 +13,92 @@
 static struct _FileInfo {
     bool isInUse;
     bool isReadOnly;
+    uint8_t *buffer;                                                                // Buffer, NULL if unbuffered
+    int  size;                                                                      // Size of the buffer
+    int  count;                                                                     // Bytes of data in the buffer
+    int  pos;                                                                       // Next byte to read from it
+    bool isWriting;                                                                 // Holds data to write, not read ahead
+    int  fileSize;                                                                  // Size, when the position last moved
 } files[FIO_MAX_HANDLES];
 
+static bool isDirectoryInUse[FIO_MAX_DIRECTORIES];                                  // Directory handles in use.
+
 #define VALID_AND_OPEN(n) ((n) >= 0 && (n) < FIO_MAX_HANDLES && files[n].isInUse)
+#define VALID_DIRECTORY(n) ((n) >= 0 && (n) < FIO_MAX_DIRECTORIES && isDirectoryInUse[n])
+
+//
+//      When a buffer is reading, it holds count bytes read ahead from the file, of which pos have
+//      been used, so the file is count-pos bytes ahead of the position the caller sees. When
+//      writing, it holds count bytes not yet written, so the file is count bytes behind.
+//
 
 /**
  * @brief      Initialise support I/O
  */
 void FIOInitialise(void) {
+    FIOAsyncReset();
     FSYSInitialise();
-    for (int i = 0;i < FIO_MAX_HANDLES;i++) files[i].isInUse = false;
+    for (int i = 0;i < FIO_MAX_HANDLES;i++) {
+        files[i].isInUse = false;
+        files[i].buffer = NULL;
+    }
+    for (int i = 0;i < FIO_MAX_DIRECTORIES;i++) isDirectoryInUse[i] = false;
+}
+
+/**
+ * @brief      Write any waiting data, or throw away data read ahead, moving the
+ *             file back to where the caller thinks it is.
+ *
+ * @param      f       File information
+ * @param[in]  handle  The handle
+ *
+ * @return     Error code if non-zero
+ */
+static int _FIOEmptyBuffer(struct _FileInfo *f,int handle) {
+    int err = FIO_OK;
+    if (f->isWriting) {
+        if (f->count > 0) err = FSYSWrite(handle,f->buffer,f->count);
+    } else if (f->pos < f->count) {                                                 // Unread data, so move the file back.
+        err = FSYSGetSetPosition(handle,-1);
+        if (err >= 0) err = FSYSGetSetPosition(handle,err-(f->count-f->pos));
+    }
+    f->count = f->pos = 0;f->isWriting = false;
+    return (err < 0) ? err : FIO_OK;
+}
+
+/**
+ * @brief      Set or remove a buffer for an open file. Any waiting data is
+ *             written first.
+ *
+ * @param[in]  handle  The handle
+ * @param      buffer  The buffer, which must stay available until the file is
+ *                     closed, or NULL for no buffer
+ * @param[in]  size    The size, 512 bytes to 4k is sensible
+ *
+ * @return     Error code if non-zero
+ */
+int FIOSetBuffer(int handle,void *buffer,int size) {
+    if (!VALID_AND_OPEN(handle)) return FIO_ERR_HANDLE;                             // Bad handle
+    struct _FileInfo *f = &files[handle];
+    if (buffer != NULL && size < 16) return FIO_ERR_COMMAND;
+    int err = (f->buffer != NULL) ? _FIOEmptyBuffer(f,handle) : FIO_OK;
+    f->buffer = buffer;f->size = size;
+    f->count = f->pos = 0;f->isWriting = false;
+    return err;
+}
+
+/**
+ * @brief      Write any data waiting in a file's buffer
+ *
+ * @param[in]  handle  The handle
+ *
+ * @return     Error code if non-zero
+ */
+int FIOFlush(int handle) {
+    if (!VALID_AND_OPEN(handle)) return FIO_ERR_HANDLE;                             // Bad handle
+    struct _FileInfo *f = &files[handle];
+    if (f->buffer == NULL || !f->isWriting) return FIO_OK;
+    return _FIOEmptyBuffer(f,handle);
 }
 
 
@@ -32,20 +108,41 @@ void FIOInitialise(void) {
  *
  * @param      fileName  The file name
  *
- * @return     Error code if non-zero
+ * @return     Handle, or Error code if negative
  */
 int FIOOpen(char *fileName) {
+    return FIOOpenEx(fileName,FIO_OPEN_READWRITE);
+}
+
+/**
+ * @brief      Open a file, which may also create or empty it, with a single
+ *             open by the file system.
+ *
+ * @param      fileName  The file name
+ * @param[in]  mode      FIO_OPEN_READWRITE, FIO_OPEN_READ, FIO_OPEN_TRUNCATE,
+ *                       FIO_OPEN_CREATE_NEW or FIO_OPEN_APPEND
+ *
+ * @return     Handle, or Error code if negative
+ */
+int FIOOpenEx(char *fileName,int mode) {
     int i = 0;
     int res;
     while (i < FIO_MAX_HANDLES && files[i].isInUse) i++;                            // Find an unused handle.
     if (i == FIO_MAX_HANDLES) return FIO_ERR_MAXFILES;                              // None found.
-    files[i].isInUse = true;
-    files[i].isReadOnly = false;
     fileName = FIOMapFileName(fileName);                                            // Map onto CWD
-    res = FSYSOpen(i,fileName);
+    if (fileName == NULL) return FIO_ERR_COMMAND;
+    files[i].isInUse = true;
+    files[i].isReadOnly = (mode == FIO_OPEN_READ);
+    files[i].buffer = NULL;
+    res = FSYSOpenEx(i,fileName,mode);
+    if (res >= 0) {
+      res = FSYSFileSize(i);
+      files[i].fileSize = res;
+      if (res < 0) FSYSClose(i);
+    }
     if (res<0) {
       files[i].isInUse = false;
-      i = -1;
+      i = res;
     }
     return i;
 }
@@ -60,8 +157,12 @@ int FIOOpen(char *fileName) {
  */
 int FIOClose(int handle) {
     if (!VALID_AND_OPEN(handle)) return FIO_ERR_HANDLE;                             // Bad handle
+    int err = (files[handle].buffer != NULL && !files[handle].isReadOnly) ?         // Write anything waiting.
+                                                    FIOFlush(handle) : FIO_OK;
     files[handle].isInUse = false;                                                  // About to close it.
-    return FSYSClose(handle);
+    files[handle].buffer = NULL;
+    int closeErr = FSYSClose(handle);
+    return (err != FIO_OK) ? err : closeErr;
 }
 
 /**
@@ -75,7 +176,90 @@ int FIOClose(int handle) {
  */
 int FIORead(int handle,void *data,int size) {
     if (!VALID_AND_OPEN(handle)) return FIO_ERR_HANDLE;                             // Bad handle
-    return FSYSRead(handle,data,size);
+    struct _FileInfo *f = &files[handle];
+    if (f->buffer == NULL) return FSYSRead(handle,data,size);
+    if (f->isWriting) {                                                             // Switching from writing
+        int err = _FIOEmptyBuffer(f,handle);
+        if (err != FIO_OK) return err;
+    }
+    uint8_t *out = data;
+    int total = 0;
+    while (total < size) {
+        if (f->pos == f->count) {                                                   // Buffer used up.
+            if (size-total >= f->size) {                                            // Big read, go straight to the file
+                int n = FSYSRead(handle,out+total,size-total);
+                if (n < 0) return (total > 0) ? total : n;
+                return total+n;
+            }
+            int n = FSYSRead(handle,f->buffer,f->size);                             // Read ahead.
+            if (n < 0) return (total > 0) ? total : n;
+            f->count = n;f->pos = 0;
+            if (n == 0) break;                                                      // End of file
+        }
+        int n = min(size-total,f->count-f->pos);
+        memcpy(out+total,f->buffer+f->pos,n);
+        f->pos += n;total += n;
+    }
+    return total;
+}
+
+/**
+ * @brief      Read one byte from an open file.
+ *
+ * @param[in]  handle  The handle
+ *
+ * @return     The byte (0-255), FIO_ERR_EOF at the end of the file, or
+ *             another error code.
+ */
+int FIOReadByte(int handle) {
+    if (VALID_AND_OPEN(handle)) {                                                   // Quick if it is in the buffer.
+        struct _FileInfo *f = &files[handle];
+        if (f->buffer != NULL && !f->isWriting && f->pos < f->count) return f->buffer[f->pos++];
+    }
+    uint8_t c;
+    int n = FIORead(handle,&c,1);
+    if (n < 0) return n;
+    return (n == 0) ? FIO_ERR_EOF : c;
+}
+
+/**
+ * @brief      Read a line from an open file, like fgets(). Carriage returns
+ *             are removed, the line feed is kept. Lines too long for the
+ *             buffer are returned in parts.
+ *
+ * @param[in]  handle  The handle
+ * @param      line    Buffer for the line, which is 0 terminated
+ * @param[in]  size    Size of the buffer, including the terminator.
+ *
+ * @return     Number of characters read, FIO_ERR_EOF if at the end of the
+ *             file, or another error code.
+ */
+int FIOReadLine(int handle,char *line,int size) {
+    if (!VALID_AND_OPEN(handle)) return FIO_ERR_HANDLE;                             // Bad handle
+    if (size < 2) return FIO_ERR_COMMAND;
+    struct _FileInfo *f = &files[handle];
+    int n = 0;
+    while (n < size-1) {
+        if (f->buffer != NULL && !f->isWriting && f->pos < f->count) {              // Copy from the buffer up to LF
+            uint8_t *p = f->buffer+f->pos;
+            int chunk = min(size-1-n,f->count-f->pos);
+            uint8_t *lf = memchr(p,'\n',chunk);
+            if (lf != NULL) chunk = lf-p+1;
+            for (int i = 0;i < chunk;i++) {
+                if (p[i] != '\r') line[n++] = p[i];
+            }
+            f->pos += chunk;
+            if (lf != NULL) break;
+        } else {                                                                    // Otherwise a byte at a time.
+            int c = FIOReadByte(handle);
+            if (c == FIO_ERR_EOF) break;
+            if (c < 0) return c;
+            if (c != '\r') line[n++] = c;
+            if (c == '\n') break;
+        }
+    }
+    line[n] = '\0';
+    return (n == 0) ? FIO_ERR_EOF : n;
 }
 
 
@@ -89,8 +273,43 @@ int FIORead(int handle,void *data,int size) {
  */
 int FIOWrite(int handle,void *data,int size) {
     if (!VALID_AND_OPEN(handle)) return FIO_ERR_HANDLE;                             // Bad handle
-    if (files[handle].isReadOnly) return FIO_ERR_READONLY;                          // Read only (not actually implemented)
-    return FSYSWrite(handle,data,size);
+    if (files[handle].isReadOnly) return FIO_ERR_READONLY;                          // Opened with FIO_OPEN_READ
+    struct _FileInfo *f = &files[handle];
+    if (f->buffer == NULL) return FSYSWrite(handle,data,size);
+    if (!f->isWriting) {                                                            // Switching from reading
+        int err = _FIOEmptyBuffer(f,handle);
+        if (err != FIO_OK) return err;
+        f->isWriting = true;
+    }
+    if (f->count+size > f->size) {                                                  // Does not fit, so write what is waiting
+        int err = _FIOEmptyBuffer(f,handle);
+        f->isWriting = true;
+        if (err != FIO_OK) return err;
+        if (size >= f->size) return FSYSWrite(handle,data,size);                    // Big write, straight to the file
+    }
+    memcpy(f->buffer+f->count,data,size);
+    f->count += size;
+    return FIO_OK;
+}
+
+/**
+ * @brief      Write one byte to an open file
+ *
+ * @param[in]  handle  The handle
+ * @param[in]  byte    The byte
+ *
+ * @return     Error code if non-zero
+ */
+int FIOWriteByte(int handle,int byte) {
+    if (VALID_AND_OPEN(handle)) {                                                   // Quick if there is room in the buffer
+        struct _FileInfo *f = &files[handle];
+        if (f->buffer != NULL && f->isWriting && f->count < f->size && !f->isReadOnly) {
+            f->buffer[f->count++] = byte;
+            return FIO_OK;
+        }
+    }
+    uint8_t c = byte;
+    return FIOWrite(handle,&c,1);
 }
 
 
@@ -104,9 +323,96 @@ int FIOWrite(int handle,void *data,int size) {
  */
 int FIOGetSetPosition(int handle,int newPosition) {
     if (!VALID_AND_OPEN(handle)) return FIO_ERR_HANDLE;                             // Bad handle
-    return FSYSGetSetPosition(handle,newPosition);
+    struct _FileInfo *f = &files[handle];
+    if (f->buffer == NULL) {
+        int current = FSYSGetSetPosition(handle,newPosition);
+        if (newPosition >= 0) f->fileSize = max(f->fileSize,current);               // Writes may have gone past the end.
+        return current;
+    }
+    int current = FSYSGetSetPosition(handle,-1);                                    // Where the file is
+    if (current < 0) return current;
+    current += f->isWriting ? f->count : -(f->count-f->pos);                        // Where the caller thinks it is.
+    if (newPosition >= 0) {                                                         // Moving, so empty the buffer first.
+        f->fileSize = max(f->fileSize,current);
+        int err = _FIOEmptyBuffer(f,handle);
+        if (err == FIO_OK) err = FSYSGetSetPosition(handle,newPosition);
+        if (err < 0) return err;
+    }
+    return current;
+}
+
+
+/**
+ * @brief      Get the size of an open file. This is kept for each handle, so
+ *             does not need a seek to the end and back.
+ *
+ * @param[in]  handle  The handle
+ *
+ * @return     Size in bytes, or Error code if negative
+ */
+int FIOFileSize(int handle) {
+    if (!VALID_AND_OPEN(handle)) return FIO_ERR_HANDLE;                             // Bad handle
+    struct _FileInfo *f = &files[handle];
+    if (f->isReadOnly) return f->fileSize;                                          // Cannot have changed.
+    int current = FIOGetSetPosition(handle,-1);                                     // Writing since the position last
+    if (current < 0) return current;                                                // moved can only have made it
+    return max(f->fileSize,current);                                                // as long as the position.
+}
+
+/**
+ * @brief      Load a whole file into memory. It is read in one call, so
+ *             FatFS can transfer whole sectors straight into the memory.
+ *
+ * @param      fileName  The file name
+ * @param      data      Where to load it
+ * @param[in]  maxSize   Size of the memory, longer files are cut short.
+ *
+ * @return     Bytes loaded, or Error code if negative
+ */
+int FIOLoadFile(char *fileName,void *data,int maxSize) {
+    int handle = FIOOpenEx(fileName,FIO_OPEN_READ);
+    if (handle < 0) return handle;
+    int size = FIORead(handle,data,min(files[handle].fileSize,maxSize));
+    FIOClose(handle);
+    return size;
 }
 
+/**
+ * @brief      Save memory to a file, replacing it if it exists.
+ *
+ * @param      fileName  The file name
+ * @param      data      The data
+ * @param[in]  size      Size in bytes
+ *
+ * @return     Error code if non-zero
+ */
+int FIOSaveFile(char *fileName,void *data,int size) {
+    return FIOSaveFile2(fileName,data,size,NULL,0);
+}
+
+/**
+ * @brief      Save memory in two parts to a file, replacing it if it exists,
+ *             for example the text either side of an editor's gap. The space
+ *             is allocated first, then each part written in one call.
+ *
+ * @param      fileName  The file name
+ * @param      data1     The first part
+ * @param[in]  size1     Size in bytes
+ * @param      data2     The second part
+ * @param[in]  size2     Size in bytes, may be 0
+ *
+ * @return     Error code if non-zero
+ */
+int FIOSaveFile2(char *fileName,void *data1,int size1,void *data2,int size2) {
+    int err = FIO_OK;
+    int handle = FIOOpenEx(fileName,FIO_OPEN_TRUNCATE);
+    if (handle < 0) return handle;
+    FSYSPreallocate(handle,size1+size2);                                            // Does not matter if it fails.
+    if (size1 > 0) err = FIOWrite(handle,data1,size1);
+    if (size2 > 0 && err == FIO_OK) err = FIOWrite(handle,data2,size2);
+    int closeErr = FIOClose(handle);
+    return (err != FIO_OK) ? err : closeErr;
+}
 
 /**
  * @brief      Create a File
@@ -117,6 +423,7 @@ int FIOGetSetPosition(int handle,int newPosition) {
  */
 int FIOCreateFile(char *fileName) {
     fileName = FIOMapFileName(fileName);                                            // Map onto CWD
+    if (fileName == NULL) return FIO_ERR_COMMAND;
     return FSYSCreateFile(fileName);
 }
 
@@ -129,6 +436,7 @@ int FIOCreateFile(char *fileName) {
  */
 int FIOCreateDirectory(char *fileName) {
     fileName = FIOMapFileName(fileName);                                            // Map onto CWD
+    if (fileName == NULL) return FIO_ERR_COMMAND;
     return FSYSCreateDirectory(fileName);
 }
 
@@ -141,6 +449,7 @@ int FIOCreateDirectory(char *fileName) {
  */
 int FIODeleteFile(char *fileName) {
     fileName = FIOMapFileName(fileName);                                            // Map onto CWD
+    if (fileName == NULL) return FIO_ERR_COMMAND;
     return FSYSDeleteFile(fileName);
 }
 
@@ -153,8 +462,11 @@ int FIODeleteFile(char *fileName) {
  */
 int FIORenameFile(char *oldFileName,char *newFileName) {
   char newnamebuf[256];
-  strcpy(newnamebuf,FIOMapFileName(newFileName));
+  char *newName = FIOMapFileName(newFileName);
+  if (newName == NULL) return FIO_ERR_COMMAND;
+  strcpy(newnamebuf,newName);
   oldFileName = FIOMapFileName(oldFileName);                                            // Map onto CWD
+  if (oldFileName == NULL) return FIO_ERR_COMMAND;
   return FSYSRenameFile(oldFileName,newnamebuf);
 }
 
@@ -167,6 +479,7 @@ int FIORenameFile(char *oldFileName,char *newFileName) {
  */
 int FIODeleteDirectory(char *fileName) {
     fileName = FIOMapFileName(fileName);                                            // Map onto CWD
+    if (fileName == NULL) return FIO_ERR_COMMAND;
     return FSYSDeleteDirectory(fileName);
 }
 
@@ -185,13 +498,13 @@ int FIOFileInformation(char *fileName,FIOInfo *info) {
         info->isDirectory = false;
     }
     fileName = FIOMapFileName(fileName);                                            // Map onto CWD
+    if (fileName == NULL) return FIO_ERR_COMMAND;
     return FSYSFileInformation(fileName,info);
 }
 
 
 //
-//      This implementation has a 'fake' handle, but it's actually ignored and this
-//      implementation can only do one directory scan at a time.
+//      Up to FIO_MAX_DIRECTORIES directories can be read at once, each with its own handle.
 //
 
 
@@ -200,32 +513,59 @@ int FIOFileInformation(char *fileName,FIOInfo *info) {
  *
  * @param      directory  The directory to read
  *
- * @return     Error code if non-zero
+ * @return     Directory handle, or Error code if negative
  */
 int FIOOpenDirectory(char *directory) {
+    int i = 0;
+    while (i < FIO_MAX_DIRECTORIES && isDirectoryInUse[i]) i++;                     // Find an unused handle.
+    if (i == FIO_MAX_DIRECTORIES) return FIO_ERR_MAXFILES;                          // None found.
     directory = FIOMapFileName(directory);                                          // Map onto CWD
-    return FSYSOpenDirectory(directory);
+    if (directory == NULL) return FIO_ERR_COMMAND;
+    int err = FSYSOpenDirectory(i,directory);
+    if (err != FIO_OK) return err;
+    isDirectoryInUse[i] = true;
+    return i;
+}
+
+/**
+ * @brief      Read the next directory entry with its size and type. This
+ *             comes from reading the directory, so is much quicker than
+ *             FIOFileInformation() on each name.
+ *
+ * @param[in]  handle  The directory handle
+ * @param      info    Information about the entry
+ *
+ * @return     Error code if non-zero, FIO_EOF at the end.
+ */
+int FIOReadDirectoryEx(int handle,FIOInfo *info) {
+    if (!VALID_DIRECTORY(handle)) return FIO_ERR_HANDLE;                            // Bad handle
+    return FSYSReadDirectory(handle,info);
 }
 
 /**
  * @brief      Read next directory 
  *
- * @param[in]  handle    The handle
+ * @param[in]  handle    The directory handle
  * @param      fileName  The file name read
  *
- * @return     Error code if non-zero
+ * @return     Error code if non-zero, FIO_EOF at the end.
  */
 int FIOReadDirectory(int handle,char *fileName) {
-    return FSYSReadDirectory(fileName);
+    FIOInfo info;
+    int err = FIOReadDirectoryEx(handle,&info);
+    if (err == FIO_OK) strcpy(fileName,info.name);
+    return err;
 }
 
 /**
  * @brief      Close a directory
  *
- * @param[in]  handle  The handle
+ * @param[in]  handle  The directory handle
  *
  * @return     Error code if non-zero
  */
 int FIOCloseDirectory(int handle) {
-    return FSYSCloseDirectory();
+    if (!VALID_DIRECTORY(handle)) return FIO_ERR_HANDLE;                            // Bad handle
+    isDirectoryInUse[handle] = false;
+    return FSYSCloseDirectory(handle);
 }
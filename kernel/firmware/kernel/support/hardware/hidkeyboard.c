@@ -0,0 +1,270 @@
+/**
+ * @file       hidkeyboard.c
+ *
+ * @brief      Converts USB HID keyboard reports into key up and down events,
+ *             by comparing each report with the keys that were down before.
+ *             The layout of the reports comes from the keyboard's report
+ *             descriptor, which may give an array of key codes, as the
+ *             boot protocol does, or an NKRO bitmap, and a report ID. This
+ *             has no USB code, so the simulator can check it.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "common.h"
+
+#define HID_ERROR_ROLLOVER  (0x01)                                              // Too many keys, the report is meaningless
+#define HID_FIRST_KEY       (0x04)                                              // Codes below this are not keys
+#define HID_PAGE_KEYBOARD   (0x07)                                              // Usage page of key codes
+#define HID_FIRST_MODIFIER  (0xE0)                                              // Usage of Left Control
+
+static uint8_t keysDown[HID_BITMAP_BYTES];                                      // One bit for each key down.
+static uint8_t arrayKeys[HID_MAX_ARRAY_KEYS];                                   // Keys down in the last key array.
+static int arrayCount = 0;
+
+static struct _HIDFormat {
+    uint8_t reportId;                                                           // Report ID of key reports, 0 if none
+    int  modifierBit;                                                           // Bit offset of the modifiers, -1 if none
+    int  keyBit;                                                                // Bit offset of the keys
+    int  keyCount;                                                              // Keys in the array, or bits in the bitmap
+    int  firstUsage;                                                            // Key code of the first bitmap bit.
+    bool isBitmap;                                                              // Bitmap (NKRO), rather than an array
+} format;
+
+/**
+ * @brief      Use the boot protocol report format, modifiers, reserved and
+ *             six key codes.
+ */
+static void _HIDBootFormat(void) {
+    format.reportId = 0;format.modifierBit = 0;
+    format.keyBit = 16;format.keyCount = HID_BOOT_KEYS;
+    format.firstUsage = 0;format.isBitmap = false;
+}
+
+/**
+ * @brief      Forget all keys, without generating events, and expect boot
+ *             protocol reports.
+ */
+void HIDKeyboardReset(void) {
+    memset(keysDown,0,sizeof(keysDown));
+    arrayCount = 0;
+    _HIDBootFormat();
+}
+
+/**
+ * @brief      Record a key changing and tell the handler.
+ *
+ * @param[in]  key        HID usage code
+ * @param[in]  isDown     true if pressed
+ * @param[in]  modifiers  Modifiers from the report
+ * @param[in]  handler    Event handler
+ */
+static void _HIDKeyChange(uint8_t key,bool isDown,uint8_t modifiers,HIDKEYHANDLER handler) {
+    if (isDown) {
+        keysDown[key >> 3] |= (1 << (key & 7));
+    } else {
+        keysDown[key >> 3] &= ~(1 << (key & 7));
+    }
+    if (key >= KEY_KP1 && key < KEY_KP1+10) key = key - KEY_KP1 + KEY_1;        // Numeric keypad numbers will work.
+    if (key < KBD_MAX_KEYCODE) (*handler)(isDown,key,isDown ? modifiers:0);
+}
+
+/**
+ * @brief      Release every key that is down
+ *
+ * @param[in]  handler  Event handler
+ */
+static void _HIDReleaseAll(HIDKEYHANDLER handler) {
+    for (int i = 0;i < HID_BITMAP_BYTES;i++) {
+        while (keysDown[i] != 0) _HIDKeyChange(i*8+__builtin_ctz(keysDown[i]),false,0,handler);
+    }
+    arrayCount = 0;
+}
+
+/**
+ * @brief      Get a bit from a report
+ *
+ * @param      data  Report data
+ * @param[in]  bit   Bit offset
+ *
+ * @return     0 or 1
+ */
+static int _HIDGetBit(uint8_t const *data,int bit) {
+    return (data[bit >> 3] >> (bit & 7)) & 1;
+}
+
+/**
+ * @brief      Process a report with an array of key codes, as the boot
+ *             protocol has.
+ *
+ * @param      data       Report data, after any report ID
+ * @param[in]  modifiers  Modifiers from the report
+ * @param[in]  handler    Event handler
+ */
+static void _HIDArrayReport(uint8_t const *data,uint8_t modifiers,HIDKEYHANDLER handler) {
+    uint8_t keys[HID_MAX_ARRAY_KEYS];
+    int count = min(format.keyCount,HID_MAX_ARRAY_KEYS);
+    if ((format.keyBit & 7) == 0) {                                             // Normally byte aligned
+        memcpy(keys,data+format.keyBit/8,count);
+    } else {
+        for (int i = 0;i < count;i++) {
+            keys[i] = 0;
+            for (int b = 0;b < 8;b++) keys[i] |= _HIDGetBit(data,format.keyBit+i*8+b) << b;
+        }
+    }
+    if (keys[0] == HID_ERROR_ROLLOVER) return;                                  // Rollover, keep the current state.
+    int kept = 0;
+    for (int i = 0;i < arrayCount;i++) {                                        // Keys no longer in the report are up.
+        if (memchr(keys,arrayKeys[i],count) == NULL) {
+            _HIDKeyChange(arrayKeys[i],false,modifiers,handler);
+        } else {
+            arrayKeys[kept++] = arrayKeys[i];
+        }
+    }
+    arrayCount = kept;
+    for (int i = 0;i < count;i++) {                                             // Keys not already down are pressed.
+        uint8_t key = keys[i];
+        if (key >= HID_FIRST_KEY && (keysDown[key >> 3] & (1 << (key & 7))) == 0) {
+            _HIDKeyChange(key,true,modifiers,handler);
+            arrayKeys[arrayCount++] = key;
+        }
+    }
+}
+
+/**
+ * @brief      Process an NKRO report, a bitmap with a bit for each key.
+ *
+ * @param      data       Report data, after any report ID
+ * @param[in]  modifiers  Modifiers from the report
+ * @param[in]  handler    Event handler
+ */
+static void _HIDBitmapReport(uint8_t const *data,uint8_t modifiers,HIDKEYHANDLER handler) {
+    uint8_t built[HID_BITMAP_BYTES];
+    uint8_t const *bitmap = data+1;
+    int bytes = format.keyCount/8;
+    if (format.keyBit != 8 || format.firstUsage != 0 || (format.keyCount & 7) != 0) {  // Not straight after the modifiers,
+        memset(built,0,sizeof(built));                                          // so move each bit to its key code.
+        for (int i = 0;i < format.keyCount;i++) {
+            int key = format.firstUsage+i;
+            if (_HIDGetBit(data,format.keyBit+i)) built[key >> 3] |= 1 << (key & 7);
+        }
+        bitmap = built;bytes = HID_BITMAP_BYTES;
+    }
+    for (int i = 0;i < bytes;i++) {
+        uint8_t changed = (bitmap[i] ^ keysDown[i]) & (i == 0 ? 0xF0 : 0xFF);  // Skip the error codes below key 4.
+        while (changed != 0) {
+            int bit = __builtin_ctz(changed);
+            changed &= changed-1;
+            _HIDKeyChange(i*8+bit,(bitmap[i] >> bit) & 1,modifiers,handler);
+        }
+    }
+}
+
+/**
+ * @brief      Read the keyboard report layout from a report descriptor, and
+ *             release any keys held on the last keyboard. Only the main
+ *             items of the keyboard usage page are used: the modifiers (a
+ *             bitmap from Left Control), and the keys, either an array of
+ *             8 bit codes or a bitmap with a bit for each key.
+ *
+ * @param      desc     Report descriptor, NULL to use the boot protocol
+ * @param[in]  len      Length of the descriptor
+ * @param[in]  handler  Event handler
+ *
+ * @return     true if key reports were found, false if the boot protocol
+ *             should be used.
+ */
+bool HIDKeyboardSetDescriptor(uint8_t const *desc,int len,HIDKEYHANDLER handler) {
+    int usagePage = 0,reportSize = 0,reportCount = 0,reportId = 0;
+    int usageMin = 0,bitPos = 0,modifierId = 0;
+    bool hasKeys = false;
+    _HIDReleaseAll(handler);
+    _HIDBootFormat();
+    format.modifierBit = -1;
+    for (int i = 0;desc != NULL && i < len;) {
+        uint8_t prefix = desc[i++];
+        if (prefix == 0xFE) {                                                   // Long item, skipped.
+            if (i+1 < len) i += 2+desc[i];
+            continue;
+        }
+        int size = (prefix & 3) == 3 ? 4 : (prefix & 3);
+        if (i+size > len) break;
+        uint32_t data = 0;
+        for (int b = 0;b < size;b++) data |= (uint32_t)desc[i+b] << (b*8);
+        i += size;
+        switch(prefix & 0xFC) {
+            case 0x04:  usagePage = data;break;                                 // Global items
+            case 0x74:  reportSize = data;break;
+            case 0x94:  reportCount = data;break;
+            case 0x84:                                                          // Report ID, a new report.
+                if ((int)data != reportId) bitPos = 0;
+                reportId = data;
+                break;
+            case 0x08:                                                          // Local items, the first usage or usage minimum
+                if (usageMin == 0) usageMin = data & 0xFFFF;
+                break;
+            case 0x18:  usageMin = data & 0xFFFF;break;
+            case 0x80:                                                          // Input
+                if (usagePage == HID_PAGE_KEYBOARD && (data & 1) == 0 && (!hasKeys || reportId == format.reportId)) {
+                    bool isVariable = (data & 2) != 0;
+                    if (isVariable && reportSize == 1 && usageMin == HID_FIRST_MODIFIER) {
+                        format.modifierBit = bitPos;modifierId = reportId;
+                    } else if (!hasKeys && isVariable && reportSize == 1) {
+                        format.isBitmap = true;format.keyBit = bitPos;format.firstUsage = usageMin;
+                        format.keyCount = min(reportCount,HID_BITMAP_BYTES*8-usageMin);
+                        format.reportId = reportId;hasKeys = true;
+                    } else if (!hasKeys && !isVariable && reportSize == 8) {
+                        format.isBitmap = false;format.keyBit = bitPos;format.keyCount = reportCount;
+                        format.reportId = reportId;hasKeys = true;
+                    }
+                }
+                bitPos += reportSize*reportCount;
+                usageMin = 0;
+                break;
+            case 0x90:  case 0xB0:  case 0xA0:  case 0xC0:                      // Other main items clear the locals.
+                usageMin = 0;
+                break;
+        }
+    }
+    if (!hasKeys || format.keyCount <= 0) {                                     // Not understood, use the boot protocol.
+        _HIDBootFormat();
+        return false;
+    }
+    if (modifierId != format.reportId) format.modifierBit = -1;                 // Modifiers must be in the key reports.
+    return true;
+}
+
+/**
+ * @brief      Process a keyboard report, calling the handler for each key
+ *             that has gone up or down since the last one.
+ *
+ * @param      report   The report, laid out as the descriptor given to
+ *                      HIDKeyboardSetDescriptor() says
+ * @param[in]  len      The length
+ * @param[in]  handler  Event handler
+ *
+ * @return     true if the reboot keys (Ctrl+Alt+AltGr) are held down.
+ */
+bool HIDKeyboardReport(uint8_t const *report,int len,HIDKEYHANDLER handler) {
+    if (format.reportId != 0) {                                                 // Other reports, e.g. media keys, are ignored
+        if (len < 1 || report[0] != format.reportId) return false;
+        report++;len--;
+    }
+    int bits = format.keyBit+format.keyCount*(format.isBitmap ? 1 : 8);
+    if (len*8 < max(bits,format.modifierBit+8)) return false;                   // Too short to hold the keys.
+    uint8_t modifiers = 0;
+    if (format.modifierBit >= 0 && (format.modifierBit & 7) == 0) {
+        modifiers = report[format.modifierBit/8];
+    } else {
+        for (int b = 0;b < 8 && format.modifierBit >= 0;b++) modifiers |= _HIDGetBit(report,format.modifierBit+b) << b;
+    }
+    if (format.isBitmap) {
+        _HIDBitmapReport(report,modifiers,handler);
+    } else {
+        _HIDArrayReport(report,modifiers,handler);
+    }
+    return (modifiers & REBOOT_KEYS) == REBOOT_KEYS;
+}
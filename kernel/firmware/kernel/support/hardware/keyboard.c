@@ -11,7 +11,13 @@
 
 #include "common.h"
 
-#define MAX_QUEUE_SIZE (64)                                                     // Max size of keyboard queue.
+#ifndef ARTURO_KBD_QUEUE_SIZE                                                   // Type ahead, set in config.make
+#define ARTURO_KBD_QUEUE_SIZE (256)
+#endif
+#define KBD_QUEUE_MASK (ARTURO_KBD_QUEUE_SIZE-1)
+#if (ARTURO_KBD_QUEUE_SIZE & KBD_QUEUE_MASK) != 0
+#error "ARTURO_KBD_QUEUE_SIZE must be a power of 2"
+#endif
 
 //
 //      Bit patterns for the key states. These represent the key codes (see kbdcodes.h)
@@ -21,10 +27,13 @@
 static uint8_t keyboardState[KBD_MAX_KEYCODE+1];
 static uint8_t keyboardModifiers;
 //
-//      Queue of ASCII keycode presses.
+//      Queue of ASCII keycode presses. This is a ring with one producer (key events and repeat)
+//      which only writes queueHead, and one consumer (KBDGetKey) which only writes queueTail. The
+//      counts are free running, so head-tail is the number of keys queued.
 //
-static uint8_t queue[MAX_QUEUE_SIZE+1];
-static uint8_t queueSize = 0;
+static uint8_t queue[ARTURO_KBD_QUEUE_SIZE];
+static volatile uint32_t queueHead = 0,queueTail = 0;
+static uint32_t queueOverflows = 0;                                             // Keys lost because the queue was full.
 
 static uint8_t currentASCII = 0,currentKeyCode = 0;                             // Current key pressed.
 static uint32_t nextRepeat = 9999;                                              // Time of next repeat.
@@ -49,7 +58,7 @@ void KBDReceiveEvent(uint8_t isDown,uint8_t keyCode,uint8_t modifiers) {
     }
 
     if (keyCode == 0xFF) {                                                      // Reset request
-        queueSize = 0;                                                          // Empty keyboard queue
+        queueHead = queueTail;                                                  // Empty keyboard queue
         for (unsigned int i = 0;i < sizeof(keyboardState);i++) {                // No keys down.
             keyboardState[i] = 0;
         escapeFlag = false;                                                     // Reset escape.
@@ -58,6 +67,7 @@ void KBDReceiveEvent(uint8_t isDown,uint8_t keyCode,uint8_t modifiers) {
     }
 
     if (keyCode != 0 && keyCode < KBD_MAX_KEYCODE) {                            // Legitimate keycode.
+        EVTRecord(isDown ? EVT_KEY_DOWN:EVT_KEY_UP,modifiers,keyCode,0,0);      // Add to the event queue
         if (isDown) {
             keyboardState[keyCode] = 0xFF;                                      // Set down flag.
             keyboardModifiers = modifiers;                                      // Copy modifiers
@@ -152,12 +162,51 @@ int KBDEscapePressed(int resetEscape) {
  * @param[in]  ascii  The ascii value
  */
 void KBDInsertQueue(int ascii) {
-    if (queueSize < MAX_QUEUE_SIZE) {                                           // Do we have a full queue ?
-        queue[queueSize] = ascii;                                               // If not insert it.
-        queueSize++;
+    uint32_t head = queueHead;
+    if (head-__atomic_load_n(&queueTail,__ATOMIC_ACQUIRE) < ARTURO_KBD_QUEUE_SIZE) {  // Do we have a full queue ?
+        queue[head & KBD_QUEUE_MASK] = ascii;                                   // If not insert it.
+        __atomic_store_n(&queueHead,head+1,__ATOMIC_RELEASE);                   // Then make it visible.
+    } else {
+        queueOverflows++;
     }
 }
 
+/**
+ * @brief      Insert several keys into the keyboard queue, e.g. pasted text.
+ *             As many as will fit are inserted, the rest are left for the
+ *             caller, and are not counted as overflows.
+ *
+ * @param      text   Keys to insert
+ * @param[in]  count  Number of keys
+ *
+ * @return     Number of keys inserted.
+ */
+int KBDInsertQueueBulk(const char *text,int count) {
+    uint32_t head = queueHead;
+    int n = min(count,KBDQueueFree());
+    for (int i = 0;i < n;i++) queue[(head+i) & KBD_QUEUE_MASK] = text[i];
+    __atomic_store_n(&queueHead,head+n,__ATOMIC_RELEASE);                       // Publish them all at once.
+    return n;
+}
+
+/**
+ * @brief      Get the free space in the keyboard queue
+ *
+ * @return     Number of keys that can be inserted.
+ */
+int KBDQueueFree(void) {
+    return ARTURO_KBD_QUEUE_SIZE-(int)(queueHead-__atomic_load_n(&queueTail,__ATOMIC_ACQUIRE));
+}
+
+/**
+ * @brief      Get the number of keys lost because the queue was full.
+ *
+ * @return     Overflow count since power on.
+ */
+uint32_t KBDGetOverflowCount(void) {
+    return queueOverflows;
+}
+
 
 /**
  * @brief      Check keyboard queue
@@ -165,7 +214,7 @@ void KBDInsertQueue(int ascii) {
  * @return     Returns non -zero if key available
  */
 int KBDIsKeyAvailable(void) {
-    return queueSize != 0;
+    return __atomic_load_n(&queueHead,__ATOMIC_ACQUIRE) != queueTail;
 }
 
 
@@ -175,10 +224,10 @@ int KBDIsKeyAvailable(void) {
  * @return     ASCII value or 0 if no key
  */
 int KBDGetKey(void) {
-    if (queueSize == 0) return 0;                                               // Queue empty.
-    uint8_t key = queue[0];
-    for (uint8_t i = 0;i < queueSize;i++) queue[i] = queue[i+1];                // Dequeue it
-    queueSize--;
+    uint32_t tail = queueTail;
+    if (__atomic_load_n(&queueHead,__ATOMIC_ACQUIRE) == tail) return 0;         // Queue empty.
+    uint8_t key = queue[tail & KBD_QUEUE_MASK];
+    __atomic_store_n(&queueTail,tail+1,__ATOMIC_RELEASE);                       // Dequeue it
     return key;
 }
 
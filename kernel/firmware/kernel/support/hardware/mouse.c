@@ -51,6 +51,7 @@ bool MSEMousePresent(void) {
  * @param[in]  y     y position
  */
 void MSESetPosition(int x,int y) {
+    if (x != xCursor || y != yCursor) EVTRecord(EVT_MOUSE_MOVE,0,0,x,y);
     xCursor = x;
     yCursor = y;
 }
@@ -76,6 +77,7 @@ void MSEOffsetPosition(int dx, int dy) {
     }
     if(xCursor > dmi->width) xCursor = dmi->width;
     if(yCursor > dmi->height) yCursor = dmi->height;
+    if (dx != 0 || dy != 0) EVTRecord(EVT_MOUSE_MOVE,0,0,xCursor,yCursor);
 }
 
 
@@ -85,6 +87,7 @@ void MSEOffsetPosition(int dx, int dy) {
  * @param[in]  ds    Scroll wheel data
  */
 void MSEUpdateScrollWheel(int ds) {
+    if (ds != 0) EVTRecord(EVT_MOUSE_WHEEL,0,0,0,ds);
     scrollWheelState += ds;
 }
 
@@ -94,6 +97,7 @@ void MSEUpdateScrollWheel(int ds) {
  * @param[in]  bs    One bit per button.
  */
 void MSEUpdateButtonState(int bs) {
+    if (bs != buttonState) EVTRecord(EVT_MOUSE_BUTTON,0,bs,0,0);
     buttonState = bs;
 }
 
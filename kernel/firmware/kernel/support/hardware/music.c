@@ -0,0 +1,251 @@
+/**
+ * @file       music.c
+ *
+ * @brief      Tracker style music player. Songs are read into memory when
+ *             they are loaded, and played on the 50Hz tick using the sound
+ *             queues, so the application does not have to do anything once
+ *             a song is started, and the tick never waits for the file
+ *             system.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "common.h"
+
+//
+//      Song file format, all values little endian.
+//
+//      0       "AMUS"
+//      4       Version (1)
+//      5       Channels used (1-4)
+//      6       Ticks per row (1-255)
+//      7       Rows per pattern (1-64)
+//      8       Number of patterns (1-255)
+//      9       Length of the order list (1-255)
+//      10      Order list position to loop back to
+//      11      Number of envelopes
+//      12      Envelopes, 14 bytes each : number, then the 13 BBC ENVELOPE parameters from T to ALD
+//              Order list, pattern numbers
+//              Offset in the file of each pattern, 4 bytes each
+//
+//      Pattern : 2 byte length of the data, then for each row a byte with a bit set for each channel
+//      with an event, followed by 3 bytes for each of those channels.
+//
+//      Event   : pitch (0-254, MUS_NOTE_OFF silences), sound type, amplitude (-15..0 or envelope 1-16)
+//
+
+#define MUS_HEADER_SIZE     (12)
+#define MUS_ENVELOPE_SIZE   (14)
+#define MUS_MAX_ROWS        (64)
+#define MUS_CHANNELS        (4)
+#define MUS_PATTERN_SIZE    (MUS_MAX_ROWS*(1+MUS_CHANNELS*3))                       // Largest pattern
+#define MUS_SONG_SIZE       (8192)                                                  // Space for all the patterns of a song
+#define MUS_NOTE_OFF        (255)
+
+static bool isLoaded = false;                                                       // A song has been loaded.
+static uint8_t header[MUS_HEADER_SIZE];
+static uint8_t orderList[256];
+static uint32_t patternOffset[256];                                                 // Pattern offsets in the file
+static uint16_t patternStart[256];                                                  // Pattern offsets in songData
+static uint8_t songData[MUS_SONG_SIZE];                                             // All the patterns.
+
+static bool isPlaying = false,isLooping = false;
+static int orderPos,row,tickCount,dataPos;                                          // Position in the song and pattern
+
+/**
+ * @brief      Check a pattern, so it can be played without further checks.
+ *             Every row must be there, with events only for the channels
+ *             used, each a note off or a valid sound type and amplitude.
+ *
+ * @param      p     Pattern data
+ * @param[in]  size  Size of the pattern data
+ *
+ * @return     true if it can be played.
+ */
+static bool _MUSCheckPattern(uint8_t *p,int size) {
+    uint8_t *end = p+size;
+    for (int r = 0;r < header[7];r++) {
+        if (p >= end) return false;                                                 // Missing row
+        uint8_t mask = *p++;
+        if (mask >> header[5]) return false;                                        // Channel not used by the song
+        for (int c = 0;c < header[5];c++) {
+            if (mask & (1 << c)) {
+                if (end-p < 3) return false;
+                int type = p[1],amplitude = (int8_t)p[2];
+                if (p[0] != MUS_NOTE_OFF &&
+                        ((type != SNDTYPE_SQUARE && type != SNDTYPE_NOISE && type != SNDTYPE_WAVETABLE) ||
+                                            amplitude < -15 || amplitude > SND_ENVELOPES)) return false;
+                p += 3;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief      Read every pattern into songData, checking each one.
+ *
+ * @param[in]  handle  Song file handle
+ *
+ * @return     0 or error code.
+ */
+static int _MUSLoadPatterns(int handle) {
+    uint8_t length[2];
+    int used = 0;
+    for (int i = 0;i < header[9];i++) {                                             // Order list must only have real patterns
+        if (orderList[i] >= header[8]) return FIO_ERR_COMMAND;
+    }
+    for (int pattern = 0;pattern < header[8];pattern++) {
+        int err = FIOGetSetPosition(handle,patternOffset[pattern]);
+        if (err < 0) return err;
+        if (FIORead(handle,length,2) != 2) return FIO_ERR_SYSTEM;
+        int size = length[0] | (length[1] << 8);
+        if (size > MUS_PATTERN_SIZE || size > MUS_SONG_SIZE-used) return FIO_ERR_COMMAND;
+        if (FIORead(handle,songData+used,size) != size) return FIO_ERR_SYSTEM;
+        if (!_MUSCheckPattern(songData+used,size)) return FIO_ERR_COMMAND;
+        patternStart[pattern] = used;
+        used += size;
+    }
+    return 0;
+}
+
+/**
+ * @brief      Work out the order position after the given one.
+ *
+ * @param[in]  pos   Order position
+ *
+ * @return     Next position, -1 if the song has ended.
+ */
+static int _MUSNextOrder(int pos) {
+    if (++pos < header[9]) return pos;
+    return isLooping ? header[10] : -1;
+}
+
+/**
+ * @brief      Stop playing and forget any song
+ */
+void MUSStop(void) {
+    if (isPlaying) SNDFlushQueues();
+    isPlaying = false;
+    isLoaded = false;
+}
+
+/**
+ * @brief      Load a song, reading the header, order list and every pattern,
+ *             which are checked here so they can be played as they are.
+ *
+ * @param      fileName  The file name
+ *
+ * @return     0 or error code.
+ */
+int MUSLoad(char *fileName) {
+    MUSStop();
+    int songHandle = FIOOpenEx(fileName,FIO_OPEN_READ);
+    if (songHandle < 0) return songHandle;
+    int err = FIO_ERR_COMMAND;                                                      // Error if the header is bad.
+    if (FIORead(songHandle,header,MUS_HEADER_SIZE) == MUS_HEADER_SIZE &&
+                    memcmp(header,"AMUS",4) == 0 && header[4] == 1 &&
+                    header[5] >= 1 && header[5] <= MUS_CHANNELS && header[6] != 0 &&
+                    header[7] >= 1 && header[7] <= MUS_MAX_ROWS && header[8] != 0 && header[9] != 0 &&
+                    header[10] < header[9] && header[11] <= SND_ENVELOPES) {
+        err = 0;
+        for (int i = 0;i < header[11] && err == 0;i++) {                            // Define envelopes
+            uint8_t e[MUS_ENVELOPE_SIZE];
+            if (FIORead(songHandle,e,MUS_ENVELOPE_SIZE) != MUS_ENVELOPE_SIZE) {
+                err = FIO_ERR_SYSTEM;
+            } else {
+                SNDENVELOPE env = { .stepLength = e[1],
+                                    .pitchChange = { (int8_t)e[2],(int8_t)e[3],(int8_t)e[4] },
+                                    .pitchSteps = { e[5],e[6],e[7] },
+                                    .attack = (int8_t)e[8],.decay = (int8_t)e[9],
+                                    .sustain = (int8_t)e[10],.release = (int8_t)e[11],
+                                    .attackLevel = e[12],.decayLevel = e[13] };
+                SNDDefineEnvelope(e[0],&env);
+            }
+        }
+        uint8_t offsets[4];
+        if (err == 0 && FIORead(songHandle,orderList,header[9]) != header[9]) err = FIO_ERR_SYSTEM;
+        for (int i = 0;i < header[8] && err == 0;i++) {                             // Pattern offsets
+            if (FIORead(songHandle,offsets,4) != 4) err = FIO_ERR_SYSTEM;
+            patternOffset[i] = offsets[0] | (offsets[1] << 8) | (offsets[2] << 16) | ((uint32_t)offsets[3] << 24);
+        }
+        if (err == 0) err = _MUSLoadPatterns(songHandle);
+    }
+    FIOClose(songHandle);
+    isLoaded = (err == 0);
+    return err;
+}
+
+/**
+ * @brief      Start playing the loaded song from the beginning.
+ *
+ * @param[in]  loop  If true, go back to the loop position at the end,
+ *                   otherwise stop.
+ *
+ * @return     0 or error code.
+ */
+int MUSPlay(bool loop) {
+    if (!isLoaded) return FIO_ERR_HANDLE;
+    isPlaying = false;
+    isLooping = loop;
+    orderPos = 0;row = 0;tickCount = 0;
+    dataPos = patternStart[orderList[orderPos]];
+    for (int i = 0;i < header[5];i++) SNDQueueNote(i,SNDTYPE_SQUARE,0,0,0,true);    // Stop anything playing
+    isPlaying = true;
+    return 0;
+}
+
+/**
+ * @brief      Check if a song is playing
+ *
+ * @return     true if playing
+ */
+bool MUSIsPlaying(void) {
+    return isPlaying;
+}
+
+/**
+ * @brief      Play one row, sending each event to the sound queues. The
+ *             channels, types and amplitudes were checked when it was loaded.
+ */
+static void _MUSPlayRow(void) {
+    uint8_t *p = songData+dataPos;
+    uint8_t mask = *p++;
+    for (int c = 0;c < header[5];c++) {
+        if (mask & (1 << c)) {
+            if (p[0] == MUS_NOTE_OFF) {
+                SNDQueueNote(c,SNDTYPE_SQUARE,0,0,0,true);
+            } else {
+                SNDQueueNote(c,p[1],(int8_t)p[2],p[0],SND_FOREVER,true);
+            }
+            p += 3;
+        }
+    }
+    dataPos = p-songData;
+}
+
+/**
+ * @brief      Advance the song, called on the 50Hz tick before the sound
+ *             queues are processed. This plays at most one row, and does
+ *             not use the file system.
+ */
+void MUSTick(void) {
+    if (!isPlaying) return;
+    if (tickCount == 0) _MUSPlayRow();                                              // Time for a new row.
+    if (++tickCount == header[6]) {                                                 // End of row
+        tickCount = 0;
+        if (++row == header[7]) {                                                   // End of pattern
+            row = 0;
+            orderPos = _MUSNextOrder(orderPos);
+            if (orderPos < 0) {                                                     // End of song
+                SNDFlushQueues();
+                isPlaying = false;
+                return;
+            }
+            dataPos = patternStart[orderList[orderPos]];
+        }
+    }
+}
@@ -0,0 +1,333 @@
+/**
+ * @file       sectorcache.c
+ *
+ * @brief      Sector cache between FatFS and the storage device. Keeps
+ *             recently used sectors (mostly FAT and directory sectors),
+ *             reads ahead when sectors are read in order, and holds writes
+ *             so that neighbouring sectors are written in one transfer,
+ *             without waiting for it to finish. Multi-sector file data
+ *             transfers go straight to the device. The device is given as
+ *             functions, so a disk image can be used on the host.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "common.h"
+
+struct _CacheSlot {
+    bool     isUsed,isDirty;                                                    // Holds a sector, not yet written.
+    uint8_t  drive;
+    uint32_t sector;
+    uint32_t lastUsed;                                                          // Use clock when last accessed, for LRU
+};
+
+static struct _CacheSlot slots[SEC_CACHE_SECTORS];
+static uint8_t cacheData[SEC_CACHE_SECTORS][SEC_SECTOR_SIZE];
+static uint8_t staging[SEC_TRANSFER_SECTORS][SEC_SECTOR_SIZE];                  // Read ahead, and runs being written
+
+static SECTRANSFER deviceTransfer = NULL;
+static SECWAIT deviceWait = NULL;
+static SECSIZE deviceSize = NULL;
+static bool isBusy = false;                                                     // A transfer may be running
+static uint8_t busyDrive;
+static int pendingError = 0;                                                    // Error from a write not waited for.
+static uint32_t useClock = 0;
+static bool lastMissValid = false;                                              // Last sector read into the cache.
+static uint8_t lastMissDrive;
+static uint32_t lastMissSector;
+static SECSTATISTICS stats;
+
+/**
+ * @brief      Set the device functions, emptying the cache if they have
+ *             changed.
+ *
+ * @param[in]  transfer  Starts a transfer
+ * @param[in]  wait      Waits for it to finish
+ * @param[in]  size      Gets the number of sectors on a drive
+ */
+void SECSetDevice(SECTRANSFER transfer,SECWAIT wait,SECSIZE size) {
+    if (transfer == deviceTransfer && wait == deviceWait && size == deviceSize) return;
+    deviceTransfer = transfer;deviceWait = wait;deviceSize = size;
+    for (int i = 0;i < SEC_CACHE_SECTORS;i++) slots[i].isUsed = false;
+    isBusy = false;pendingError = 0;lastMissValid = false;
+}
+
+/**
+ * @brief      Wait for any transfer that is running
+ *
+ * @return     0 or error code
+ */
+static int _SECWait(void) {
+    if (isBusy) {
+        isBusy = false;
+        int err = (*deviceWait)(busyDrive);
+        if (err != 0 && pendingError == 0) pendingError = err;
+    }
+    int err = pendingError;
+    pendingError = 0;
+    return err;
+}
+
+/**
+ * @brief      Start a transfer, after the last one finishes.
+ *
+ * @param[in]  drive   The drive
+ * @param[in]  sector  First sector
+ * @param      buffer  The data
+ * @param[in]  count   Number of sectors
+ * @param[in]  isWrite true to write
+ * @param[in]  wait    Wait for it to finish
+ *
+ * @return     0 or error code
+ */
+static int _SECTransfer(uint8_t drive,uint32_t sector,uint8_t *buffer,int count,bool isWrite,bool wait) {
+    int err = _SECWait();
+    if (err != 0) return err;
+    if (isWrite) {
+        stats.writeTransfers++;stats.sectorsWritten += count;
+    } else {
+        stats.readTransfers++;stats.sectorsRead += count;
+    }
+    stats.largestTransfer = max(stats.largestTransfer,(uint32_t)count);
+    err = (*deviceTransfer)(drive,sector,buffer,count,isWrite);
+    if (err != 0) return err;
+    isBusy = true;busyDrive = drive;
+    return wait ? _SECWait() : 0;
+}
+
+/**
+ * @brief      Find a sector in the cache
+ *
+ * @param[in]  drive   The drive
+ * @param[in]  sector  The sector
+ *
+ * @return     Slot number, -1 if not present.
+ */
+static int _SECFind(uint8_t drive,uint32_t sector) {
+    for (int i = 0;i < SEC_CACHE_SECTORS;i++) {
+        if (slots[i].isUsed && slots[i].sector == sector && slots[i].drive == drive) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief      Check if a sector is in the cache and not written.
+ *
+ * @param[in]  drive   The drive
+ * @param[in]  sector  The sector
+ *
+ * @return     Slot number, -1 if not present or not dirty.
+ */
+static int _SECFindDirty(uint8_t drive,uint32_t sector) {
+    int i = _SECFind(drive,sector);
+    return (i >= 0 && slots[i].isDirty) ? i : -1;
+}
+
+/**
+ * @brief      Write a dirty sector, with any dirty sectors either side of it,
+ *             in one transfer which is not waited for.
+ *
+ * @param[in]  slot  Slot of the dirty sector
+ *
+ * @return     0 or error code
+ */
+static int _SECFlushRun(int slot) {
+    uint8_t drive = slots[slot].drive;
+    uint32_t first = slots[slot].sector,last = first;
+    while (last-first+1 < SEC_TRANSFER_SECTORS && first > 0 && _SECFindDirty(drive,first-1) >= 0) first--;
+    while (last-first+1 < SEC_TRANSFER_SECTORS && _SECFindDirty(drive,last+1) >= 0) last++;
+    int err = _SECWait();                                                       // Staging may still be being written
+    if (err != 0) return err;
+    for (uint32_t s = first;s <= last;s++) {
+        int i = _SECFind(drive,s);
+        memcpy(staging[s-first],cacheData[i],SEC_SECTOR_SIZE);
+        slots[i].isDirty = false;
+    }
+    return _SECTransfer(drive,first,staging[0],last-first+1,true,false);
+}
+
+/**
+ * @brief      Get a slot for a sector, throwing out the least recently used.
+ *
+ * @param[in]  drive     The drive
+ * @param[in]  sector    The sector
+ * @param[in]  mayFlush  If false, do not throw out a dirty sector
+ * @param[in]  keepFrom  Do not throw out sectors used at or after this
+ *                       time
+ *
+ * @return     Slot number, -1 if none available
+ */
+static int _SECAllocate(uint8_t drive,uint32_t sector,bool mayFlush,uint32_t keepFrom) {
+    int victim = -1;
+    for (int i = 0;i < SEC_CACHE_SECTORS && (victim < 0 || slots[victim].isUsed);i++) {
+        bool canUse = !slots[i].isUsed || ((mayFlush || !slots[i].isDirty) && slots[i].lastUsed < keepFrom);
+        if (canUse && (victim < 0 || !slots[i].isUsed || slots[i].lastUsed < slots[victim].lastUsed)) victim = i;
+    }
+    if (victim < 0) return -1;
+    if (slots[victim].isUsed && slots[victim].isDirty && _SECFlushRun(victim) != 0) return -1;
+    slots[victim].isUsed = true;slots[victim].isDirty = false;
+    slots[victim].drive = drive;slots[victim].sector = sector;
+    slots[victim].lastUsed = ++useClock;
+    return victim;
+}
+
+/**
+ * @brief      Read a sector into the cache, reading ahead if the last one
+ *             read was the one before. An error writing out the sector it
+ *             replaces is returned after the read, which still fills the
+ *             slot.
+ *
+ * @param[in]  drive   The drive
+ * @param[in]  sector  The sector
+ * @param      pSlot   Set to the slot number, -1 if not read
+ *
+ * @return     0 or error code
+ */
+static int _SECLoad(uint8_t drive,uint32_t sector,int *pSlot) {
+    *pSlot = -1;
+    int slot = _SECAllocate(drive,sector,true,UINT32_MAX);
+    if (slot < 0) return FIO_ERR_SYSTEM;
+    int writeErr = _SECWait();                                                  // Writing out the sector replaced.
+    bool sequential = lastMissValid && drive == lastMissDrive && sector == lastMissSector+1;
+    uint32_t size = (*deviceSize)(drive);
+    int count = (sequential && sector < size) ? (int)min((uint32_t)SEC_TRANSFER_SECTORS,size-sector) : 1;
+    if (count > 1 && _SECTransfer(drive,sector,staging[0],count,false,true) == 0) {
+        memcpy(cacheData[slot],staging[0],SEC_SECTOR_SIZE);
+        for (int i = 1;i < count;i++) {                                         // Keep what fits without writing.
+            if (_SECFind(drive,sector+i) >= 0) continue;                        // Already have it, may be newer.
+            int s = _SECAllocate(drive,sector+i,false,slots[slot].lastUsed);    // Keeping what has just been read.
+            if (s < 0) break;
+            memcpy(cacheData[s],staging[i],SEC_SECTOR_SIZE);
+            stats.readAhead++;
+        }
+    } else {
+        count = 1;
+        int err = _SECTransfer(drive,sector,cacheData[slot],1,false,true);     // Just this one.
+        if (err != 0) {
+            slots[slot].isUsed = false;
+            return (writeErr != 0) ? writeErr : err;
+        }
+    }
+    lastMissValid = true;lastMissDrive = drive;lastMissSector = sector+count-1;
+    *pSlot = slot;
+    return writeErr;
+}
+
+/**
+ * @brief      Read sectors
+ *
+ * @param[in]  drive   The drive
+ * @param[in]  sector  First sector
+ * @param      buffer  Buffer for the data
+ * @param[in]  count   Number of sectors
+ *
+ * @return     0 or error code
+ */
+int SECRead(uint8_t drive,uint32_t sector,uint8_t *buffer,int count) {
+    if (count > 1) {                                                            // File data, straight from the device
+        int err = _SECTransfer(drive,sector,buffer,count,false,true);
+        if (err != 0) return err;
+        for (int i = 0;i < SEC_CACHE_SECTORS;i++) {                             // Unwritten sectors are newer.
+            if (slots[i].isUsed && slots[i].isDirty && slots[i].drive == drive &&
+                            slots[i].sector >= sector && slots[i].sector < sector+count) {
+                memcpy(buffer+(slots[i].sector-sector)*SEC_SECTOR_SIZE,cacheData[i],SEC_SECTOR_SIZE);
+            }
+        }
+        return 0;
+    }
+    int err = 0;
+    int slot = _SECFind(drive,sector);
+    if (slot >= 0) {
+        stats.hits++;
+    } else {
+        stats.misses++;
+        err = _SECLoad(drive,sector,&slot);
+        if (slot < 0) return err;
+    }
+    slots[slot].lastUsed = ++useClock;
+    memcpy(buffer,cacheData[slot],SEC_SECTOR_SIZE);
+    return err;
+}
+
+/**
+ * @brief      Write sectors. Single sectors are kept in the cache and written
+ *             later.
+ *
+ * @param[in]  drive   The drive
+ * @param[in]  sector  First sector
+ * @param[in]  buffer  The data
+ * @param[in]  count   Number of sectors
+ *
+ * @return     0 or error code
+ */
+int SECWrite(uint8_t drive,uint32_t sector,const uint8_t *buffer,int count) {
+    if (count > 1) {                                                            // File data, straight to the device
+        for (int i = 0;i < SEC_CACHE_SECTORS;i++) {                             // Cached copies replaced.
+            if (slots[i].isUsed && slots[i].drive == drive && slots[i].sector >= sector && slots[i].sector < sector+count) {
+                memcpy(cacheData[i],buffer+(slots[i].sector-sector)*SEC_SECTOR_SIZE,SEC_SECTOR_SIZE);
+                slots[i].isDirty = false;
+            }
+        }
+        return _SECTransfer(drive,sector,(uint8_t *)buffer,count,true,true);   // The caller may reuse the buffer.
+    }
+    int slot = _SECFind(drive,sector);
+    if (slot < 0) slot = _SECAllocate(drive,sector,true,UINT32_MAX);
+    if (slot < 0) return FIO_ERR_SYSTEM;
+    memcpy(cacheData[slot],buffer,SEC_SECTOR_SIZE);
+    slots[slot].isDirty = true;slots[slot].lastUsed = ++useClock;
+    uint32_t first = sector,last = sector;                                      // Write it out if the run is full.
+    while (first > 0 && _SECFindDirty(drive,first-1) >= 0) first--;
+    while (_SECFindDirty(drive,last+1) >= 0) last++;
+    if (last-first+1 >= SEC_TRANSFER_SECTORS) return _SECFlushRun(slot);
+    return 0;
+}
+
+/**
+ * @brief      Write everything waiting for a drive, and wait for it to finish.
+ *
+ * @param[in]  drive  The drive
+ *
+ * @return     0 or error code
+ */
+int SECSync(uint8_t drive) {
+    for (int i = 0;i < SEC_CACHE_SECTORS;i++) {
+        if (slots[i].isUsed && slots[i].isDirty && slots[i].drive == drive) {
+            int err = _SECFlushRun(i);
+            if (err != 0) return err;
+        }
+    }
+    return _SECWait();
+}
+
+/**
+ * @brief      Forget a drive's sectors without writing them, when it has been
+ *             removed.
+ *
+ * @param[in]  drive  The drive
+ */
+void SECInvalidate(uint8_t drive) {
+    if (isBusy && busyDrive == drive) isBusy = false;
+    for (int i = 0;i < SEC_CACHE_SECTORS;i++) {
+        if (slots[i].drive == drive) slots[i].isUsed = false;
+    }
+    if (lastMissDrive == drive) lastMissValid = false;
+}
+
+/**
+ * @brief      Get the cache statistics
+ *
+ * @param      s     Structure to fill in
+ */
+void SECGetStatistics(SECSTATISTICS *s) {
+    *s = stats;
+}
+
+/**
+ * @brief      Reset the cache statistics
+ */
+void SECResetStatistics(void) {
+    memset(&stats,0,sizeof(stats));
+}
@@ -0,0 +1,268 @@
+/**
+ * @file       soundqueue.c
+ *
+ * @brief      BBC Micro style SOUND and ENVELOPE, notes are queued on each
+ *             channel and played by the 50Hz tick, so applications do not
+ *             have to time them.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "common.h"
+
+#define SND_QUEUE_CHANNELS  (4)                                                     // Channels with queues
+#define SND_TICK_CS         (2)                                                     // Centiseconds per 50Hz tick
+
+//
+//      Frequencies of pitches 0-47 (the lowest octave) in 1/16 Hz, pitch is in quarter semitones
+//      with 89 being 440Hz, so 53 is middle C, as on the BBC Micro.
+//
+static const uint16_t pitchTable[48] = {
+    1947,1976,2004,2033,2063,2093,2123,2154,2186,2217,2250,2282,
+    2316,2349,2383,2418,2453,2489,2525,2562,2599,2637,2675,2714,
+    2754,2794,2834,2876,2918,2960,3003,3047,3091,3136,3182,3228,
+    3275,3322,3371,3420,3470,3520,3571,3623,3676,3729,3784,3839
+};
+
+struct _QueuedNote {
+    uint8_t type;
+    int8_t  amplitude;                                                              // -15..0 fixed volume, 1-16 envelope
+    uint8_t pitch;
+    uint8_t duration;                                                               // In 1/20s, SND_FOREVER plays until flushed
+};
+
+enum { PHASE_ATTACK,PHASE_DECAY,PHASE_SUSTAIN,PHASE_RELEASE };
+
+struct _QueueChannel {
+    struct _QueuedNote queue[SND_QUEUE_DEPTH];
+    uint8_t head,tail;                                                              // Insert at head, remove at tail
+    bool    playing;                                                                // Note currently playing
+    struct _QueuedNote note;                                                        // The note playing
+    int     remaining;                                                              // Time left in cs, -1 if forever
+    int     pitch;                                                                  // Current pitch, changed by envelope
+    int     level;                                                                  // Current amplitude 0-126
+    int     phase;                                                                  // Amplitude envelope phase
+    int     section,sectionStep;                                                    // Pitch envelope section and step in it.
+    int     stepTime;                                                               // Time in cs towards the next envelope step.
+};
+
+static struct _QueueChannel queues[SND_QUEUE_CHANNELS];
+
+static SNDENVELOPE envelopes[SND_ENVELOPES];
+
+/**
+ * @brief      Convert a pitch to a frequency
+ *
+ * @param[in]  pitch  Pitch 0-255
+ *
+ * @return     Frequency in 1/16ths of a Hz
+ */
+static int _SNDPitchToFrequency(int pitch) {
+    pitch &= 0xFF;
+    return pitchTable[pitch % 48] << (pitch / 48);
+}
+
+/**
+ * @brief      Update the sound chip from the channel's pitch and level
+ *
+ * @param[in]  channel  The channel
+ * @param      qc       Queue status for the channel
+ */
+static void _SNDApply(int channel,struct _QueueChannel *qc) {
+    SNDAdjustChannel(channel,qc->note.type,_SNDPitchToFrequency(qc->pitch),qc->level);
+}
+
+/**
+ * @brief      Start the next note from the queue, or silence the channel
+ *
+ * @param[in]  channel  The channel
+ * @param      qc       Queue status for the channel
+ */
+static void _SNDStartNext(int channel,struct _QueueChannel *qc) {
+    if (qc->head == qc->tail) {                                                     // Nothing queued, so silence.
+        if (qc->playing) {
+            SNDCHANNEL c = { .type = SNDTYPE_SQUARE,.frequency = 0,.volume = 0 };
+            SNDUpdate(channel,&c);
+        }
+        qc->playing = false;
+        return;
+    }
+    qc->note = qc->queue[qc->tail];
+    qc->tail = (qc->tail+1) & (SND_QUEUE_DEPTH-1);
+    qc->playing = true;
+    qc->remaining = (qc->note.duration == SND_FOREVER) ? -1 : qc->note.duration * 5;
+    qc->pitch = qc->note.pitch;
+    qc->phase = PHASE_ATTACK;qc->section = qc->sectionStep = qc->stepTime = 0;
+    if (qc->note.amplitude > 0) {                                                   // Envelope starts at zero.
+        qc->level = 0;
+    } else {                                                                        // Fixed amplitude, -15 is loudest.
+        qc->level = -qc->note.amplitude * 126 / 15;
+    }
+    _SNDApply(channel,qc);
+}
+
+/**
+ * @brief      Do one step of a note's envelope
+ *
+ * @param      qc    Queue status for the channel
+ * @param      e     The envelope
+ */
+static void _SNDEnvelopeStep(struct _QueueChannel *qc,SNDENVELOPE *e) {
+    if (qc->section < 3) {                                                          // Pitch envelope
+        while (qc->section < 3 && qc->sectionStep >= e->pitchSteps[qc->section]) {  // Skip finished (or empty) sections
+            qc->section++;qc->sectionStep = 0;
+            if (qc->section == 3 && (e->stepLength & 0x80) == 0 &&                  // Auto repeat, unless it is all empty.
+                        (e->pitchSteps[0] | e->pitchSteps[1] | e->pitchSteps[2]) != 0) qc->section = 0;
+        }
+        if (qc->section < 3) {
+            qc->pitch = (qc->pitch + e->pitchChange[qc->section]) & 0xFF;
+            qc->sectionStep++;
+        }
+    }
+    switch(qc->phase) {                                                             // Amplitude envelope
+        case PHASE_ATTACK:
+            qc->level += e->attack;
+            if (e->attack <= 0 || qc->level >= e->attackLevel) {
+                qc->level = e->attackLevel;qc->phase = PHASE_DECAY;
+            }
+            break;
+        case PHASE_DECAY:
+            qc->level += e->decay;
+            if (e->decay == 0 || (e->decay < 0 ? qc->level <= e->decayLevel : qc->level >= e->decayLevel)) {
+                qc->level = e->decayLevel;qc->phase = PHASE_SUSTAIN;
+            }
+            break;
+        case PHASE_SUSTAIN:
+            qc->level += e->sustain;
+            break;
+        case PHASE_RELEASE:
+            qc->level += e->release;
+            break;
+    }
+    qc->level = max(0,min(126,qc->level));
+}
+
+/**
+ * @brief      Advance a channel by one tick
+ *
+ * @param[in]  channel  The channel
+ * @param      qc       Queue status for the channel
+ */
+static void _SNDTickChannel(int channel,struct _QueueChannel *qc) {
+    if (!qc->playing) {                                                             // Idle, start anything queued.
+        _SNDStartNext(channel,qc);
+        return;
+    }
+    if (qc->phase != PHASE_RELEASE && qc->remaining >= 0) {                         // Timed note, has it finished ?
+        qc->remaining -= SND_TICK_CS;
+        if (qc->remaining <= 0) {
+            if (qc->note.amplitude <= 0 || envelopes[qc->note.amplitude-1].release >= 0 || qc->head != qc->tail) {
+                _SNDStartNext(channel,qc);                                          // No release, or a note is waiting.
+                return;
+            }
+            qc->phase = PHASE_RELEASE;
+        }
+    }
+    if (qc->note.amplitude > 0) {                                                   // Envelope steps.
+        SNDENVELOPE *e = &envelopes[qc->note.amplitude-1];
+        int stepLength = max(1,e->stepLength & 0x7F);
+        qc->stepTime += SND_TICK_CS;
+        while (qc->stepTime >= stepLength) {
+            qc->stepTime -= stepLength;
+            _SNDEnvelopeStep(qc,e);
+        }
+        if (qc->phase == PHASE_RELEASE && (qc->level == 0 || qc->head != qc->tail)) {
+            _SNDStartNext(channel,qc);                                              // Released, or cut short by a new note
+            return;
+        }
+        _SNDApply(channel,qc);
+    }
+}
+
+/**
+ * @brief      Queue a note on a channel
+ *
+ * @param[in]  channel    The channel
+ * @param[in]  type       Sound type, SNDTYPE_SQUARE, SNDTYPE_NOISE or
+ *                        SNDTYPE_WAVETABLE
+ * @param[in]  amplitude  -15 (loudest) to 0 for a fixed volume, 1-16 to use
+ *                        an envelope
+ * @param[in]  pitch      Pitch 0-255 in quarter semitones, 89 is 440Hz
+ * @param[in]  duration   Duration in 1/20s, SND_FOREVER plays until flushed
+ * @param[in]  flush      Discard queued notes and stop the current one first
+ *
+ * @return     true if queued, false if the queue is full or bad parameters
+ */
+bool SNDQueueNote(int channel,int type,int amplitude,int pitch,int duration,bool flush) {
+    if (channel < 0 || channel >= SND_QUEUE_CHANNELS) return false;
+    if (amplitude < -15 || amplitude > SND_ENVELOPES || type == SNDTYPE_SAMPLE) return false;
+    struct _QueueChannel *qc = &queues[channel];
+    if (flush) {                                                                    // Flush, start this note on the next tick
+        qc->tail = qc->head;
+        qc->playing = false;
+    }
+    if (SNDQueueFree(channel) == 0) return false;
+    struct _QueuedNote *n = &qc->queue[qc->head];
+    n->type = type;n->amplitude = amplitude;n->pitch = pitch & 0xFF;n->duration = min(max(duration,0),SND_FOREVER);
+    qc->head = (qc->head+1) & (SND_QUEUE_DEPTH-1);
+    return true;
+}
+
+/**
+ * @brief      Define an envelope
+ *
+ * @param[in]  envelope  Envelope number 1-16
+ * @param      e         The envelope
+ */
+void SNDDefineEnvelope(int envelope,SNDENVELOPE *e) {
+    if (envelope < 1 || envelope > SND_ENVELOPES) return;
+    envelopes[envelope-1] = *e;
+}
+
+/**
+ * @brief      Get the free space in a channel's queue
+ *
+ * @param[in]  channel  The channel
+ *
+ * @return     Free slots, 0 if full or a bad channel.
+ */
+int SNDQueueFree(int channel) {
+    if (channel < 0 || channel >= SND_QUEUE_CHANNELS) return 0;
+    struct _QueueChannel *qc = &queues[channel];
+    return SND_QUEUE_DEPTH-1-((qc->head-qc->tail) & (SND_QUEUE_DEPTH-1));           // One slot is kept empty.
+}
+
+/**
+ * @brief      Check if a channel is playing a queued note
+ *
+ * @param[in]  channel  The channel
+ *
+ * @return     true if playing, or notes are waiting
+ */
+bool SNDIsChannelPlaying(int channel) {
+    if (channel < 0 || channel >= SND_QUEUE_CHANNELS) return false;
+    return queues[channel].playing || queues[channel].head != queues[channel].tail;
+}
+
+/**
+ * @brief      Empty all the queues and silence queued notes
+ */
+void SNDFlushQueues(void) {
+    for (int i = 0;i < SND_QUEUE_CHANNELS;i++) {
+        queues[i].tail = queues[i].head;
+        if (queues[i].playing) _SNDStartNext(i,&queues[i]);
+    }
+}
+
+/**
+ * @brief      Play the queues, called on the 50Hz tick
+ */
+void SNDTick(void) {
+    for (int i = 0;i < SND_QUEUE_CHANNELS;i++) {
+        struct _QueueChannel *qc = &queues[i];
+        if (qc->playing || qc->head != qc->tail) _SNDTickChannel(i,qc);
+    }
+}
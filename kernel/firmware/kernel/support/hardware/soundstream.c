@@ -0,0 +1,295 @@
+/**
+ * @file       soundstream.c
+ *
+ * @brief      Streams a WAV or raw sample file from the file system, so
+ *             sounds longer than memory can be played. The file is read on
+ *             the 50Hz tick into a ring of buffers, which the block mixer
+ *             plays from. Each tick reads at most twice what a tick plays,
+ *             in reads of at most 1k, so the tick is not held up for long.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "common.h"
+
+#define STR_BUFFERS         (4)                                                     // Buffers in the ring, power of 2
+#define STR_BUFFER_SIZE     (1024)                                                  // Samples in each buffer
+#define STR_READ_FRAMES     (256)                                                   // Frames read from the file at a time
+
+//
+//      The ring has a single producer, SNDStreamTick(), which fills buffers and advances
+//      writeCount, and a single consumer, the mixer, which empties them and advances readCount.
+//      Each only writes its own count, so no locking is needed. The mixer may be running while
+//      a seek is done, so a seek sets seekPending and stops filling, and the mixer drops what is
+//      in the ring and clears it. Only the mixer writes position, finished and isStarting.
+//
+static int8_t ring[STR_BUFFERS][STR_BUFFER_SIZE];
+static int ringLength[STR_BUFFERS];                                                 // Samples in each buffer
+static volatile uint32_t writeCount = 0,readCount = 0;                              // Buffers filled and emptied.
+static int fillLength = 0;                                                          // Samples in the buffer being filled
+
+static volatile bool isPlaying = false;
+static volatile bool endOfFile = false;
+static volatile bool seekPending = false;                                           // Mixer to empty the ring.
+static volatile bool finished = false;                                              // Mixer has played it all.
+static bool isStarting = false;                                                     // Mixer waiting for the first buffer
+static bool isLooping = false;
+static int streamHandle = -1;                                                       // File, -1 if none.
+static int dataStart,dataSize;                                                      // Sample data in the file, bytes
+static int channels,bytesPerSample,frameRate;                                       // Format of the sample data.
+static uint8_t signFlip;                                                            // $80 if 8 bit data is unsigned.
+static uint32_t step,position;                                                      // 16.16 step and position in buffer
+static int volume;
+static int tickFrames;                                                              // Most frames read in a tick.
+static uint32_t underruns = 0;
+static int framesRead;                                                              // Frames read from the file.
+
+/**
+ * @brief      Read a little endian value
+ *
+ * @param      p      Data
+ * @param[in]  bytes  Size in bytes
+ *
+ * @return     Value
+ */
+static uint32_t _SNDReadLE(uint8_t *p,int bytes) {
+    uint32_t v = 0;
+    while (bytes-- > 0) v = (v << 8) | p[bytes];
+    return v;
+}
+
+/**
+ * @brief      Find the format and sample data in a WAV file. Every chunk is
+ *             looked at, as they can be in any order.
+ *
+ * @return     0 or error code.
+ */
+static int _SNDStreamReadWAV(void) {
+    uint8_t chunk[16];
+    uint32_t pos = 12;
+    uint32_t fileSize = FIOFileSize(streamHandle);
+    bool hasFormat = false,hasData = false;
+    while (pos+8 <= fileSize) {
+        if (FIOGetSetPosition(streamHandle,pos) < 0 || FIORead(streamHandle,chunk,8) != 8) return FIO_ERR_COMMAND;
+        uint32_t size = _SNDReadLE(chunk+4,4);
+        if (memcmp(chunk,"fmt ",4) == 0) {                                          // Format, must be PCM 8 or 16 bit
+            if (size < 16 || FIORead(streamHandle,chunk,16) != 16) return FIO_ERR_COMMAND;
+            channels = _SNDReadLE(chunk+2,2);frameRate = _SNDReadLE(chunk+4,4);
+            bytesPerSample = _SNDReadLE(chunk+14,2)/8;
+            if (_SNDReadLE(chunk,2) != 1 || channels < 1 || channels > 2 ||
+                            bytesPerSample < 1 || bytesPerSample > 2) return FIO_ERR_COMMAND;
+            hasFormat = true;
+        }
+        if (memcmp(chunk,"data",4) == 0) {                                          // Sample data, may be cut short.
+            dataStart = pos+8;dataSize = min(size,fileSize-dataStart);
+            hasData = true;
+        }
+        if (size > fileSize) break;                                                 // Past the end, nothing follows.
+        pos += 8+size+(size & 1);                                                   // Chunks are word aligned.
+    }
+    return (hasFormat && hasData) ? 0 : FIO_ERR_COMMAND;
+}
+
+/**
+ * @brief      Read frames from the file and convert them to 8 bit mono.
+ *
+ * @param      out    Output buffer
+ * @param[in]  count  Maximum number of frames
+ *
+ * @return     Frames read, 0 at the end of the data.
+ */
+static int _SNDStreamReadFrames(int8_t *out,int count) {
+    static uint8_t raw[STR_READ_FRAMES*4];
+    int frameSize = channels*bytesPerSample;
+    int total = 0;
+    while (total < count) {
+        int n = min(min(count-total,STR_READ_FRAMES),dataSize/frameSize-framesRead);
+        if (n <= 0) break;
+        int got = FIORead(streamHandle,raw,n*frameSize);
+        if (got <= 0) break;
+        n = got/frameSize;
+        for (int i = 0;i < n;i++) {
+            uint8_t *p = raw+i*frameSize;
+            int s = (int8_t)((bytesPerSample == 1) ? p[0] ^ signFlip : p[1]);       // Top byte of 16 bit samples.
+            if (channels == 2) {
+                s += (int8_t)((bytesPerSample == 1) ? p[1] ^ signFlip : p[3]);      // Mix stereo to mono.
+                s >>= 1;
+            }
+            *out++ = s;
+        }
+        total += n;framesRead += n;
+    }
+    return total;
+}
+
+/**
+ * @brief      Pass the buffer being filled to the mixer.
+ */
+static void _SNDStreamPublish(void) {
+    ringLength[writeCount & (STR_BUFFERS-1)] = fillLength;
+    fillLength = 0;
+    __atomic_store_n(&writeCount,writeCount+1,__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief      Refill free buffers from the file, called on the 50Hz tick.
+ *             At most tickFrames are read, and anything read is passed to
+ *             the mixer, even if a buffer is not full.
+ */
+void SNDStreamTick(void) {
+    if (!isPlaying || endOfFile || __atomic_load_n(&seekPending,__ATOMIC_ACQUIRE)) return;
+    int budget = tickFrames;
+    while (budget > 0 && writeCount-__atomic_load_n(&readCount,__ATOMIC_ACQUIRE) < STR_BUFFERS) {
+        int8_t *out = ring[writeCount & (STR_BUFFERS-1)]+fillLength;
+        int want = min(budget,STR_BUFFER_SIZE-fillLength);
+        int n = _SNDStreamReadFrames(out,want);
+        fillLength += n;budget -= n;
+        if (n < want) {                                                             // End of the data
+            if (isLooping && framesRead > 0) {                                      // Loop back to the start
+                FIOGetSetPosition(streamHandle,dataStart);
+                framesRead = 0;
+                continue;
+            }
+            if (fillLength > 0) _SNDStreamPublish();                                // Nothing left.
+            endOfFile = true;
+            return;
+        }
+        if (fillLength == STR_BUFFER_SIZE) _SNDStreamPublish();                     // Full, give it to the mixer.
+    }
+    if (fillLength > 0) _SNDStreamPublish();                                        // Pass on what has been read
+}
+
+/**
+ * @brief      Mix the stream into the mixing buffer, called by the block
+ *             renderer.
+ *
+ * @param      mix    Mixing buffer
+ * @param[in]  count  Number of samples
+ *
+ * @return     true if the stream is playing.
+ */
+bool SNDStreamMix(int16_t *mix,int count) {
+    if (!isPlaying) return false;
+    if (__atomic_load_n(&seekPending,__ATOMIC_ACQUIRE)) {                           // Seeking, drop anything in the ring.
+        __atomic_store_n(&readCount,__atomic_load_n(&writeCount,__ATOMIC_ACQUIRE),__ATOMIC_RELEASE);
+        position = 0;finished = false;isStarting = true;
+        __atomic_store_n(&seekPending,false,__ATOMIC_RELEASE);                      // Filling can start again.
+        return true;
+    }
+    if (finished) return false;
+    uint32_t read = readCount;
+    for (int i = 0;i < count;i++) {
+        if (__atomic_load_n(&writeCount,__ATOMIC_ACQUIRE) == read) {                // Nothing to play
+            if (endOfFile) {                                                        // Finished.
+                finished = true;
+            } else if (!isStarting) {                                               // Not yet filled after a seek isn't an underrun.
+                underruns++;
+                PRFCount(PRF_AUDIO_UNDERRUNS,1);
+            }
+            break;
+        }
+        isStarting = false;
+        int b = read & (STR_BUFFERS-1);
+        mix[i] += (ring[b][position >> 16] * volume) >> 7;
+        position += step;
+        if ((position >> 16) >= (uint32_t)ringLength[b]) {                         // Buffer finished, give it back.
+            position -= ringLength[b] << 16;
+            __atomic_store_n(&readCount,++read,__ATOMIC_RELEASE);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief      Stop streaming and close the file.
+ */
+void SNDStreamStop(void) {
+    isPlaying = false;
+    if (streamHandle >= 0) FIOClose(streamHandle);
+    streamHandle = -1;
+}
+
+/**
+ * @brief      Open a WAV or raw file and start streaming it
+ *
+ * @param      fileName  The file name
+ * @param[in]  rawRate   Sample rate if the file is raw 8 bit signed mono,
+ *                       WAV files use their own.
+ * @param[in]  _volume   Volume 0-127
+ * @param[in]  loop      Play it repeatedly
+ *
+ * @return     0 or error code.
+ */
+int SNDStreamOpen(char *fileName,int rawRate,int _volume,bool loop) {
+    uint8_t header[12];
+    SNDStreamStop();
+    streamHandle = FIOOpenEx(fileName,FIO_OPEN_READ);
+    if (streamHandle < 0) return streamHandle;
+    int err = 0;
+    int read = FIORead(streamHandle,header,12);
+    if (read == 12 && memcmp(header,"RIFF",4) == 0 && memcmp(header+8,"WAVE",4) == 0) {
+        err = _SNDStreamReadWAV();
+        signFlip = 0x80;                                                            // WAV 8 bit samples are unsigned
+    } else {                                                                        // Raw, 8 bit signed.
+        FIOInfo info;
+        channels = 1;bytesPerSample = 1;frameRate = rawRate;signFlip = 0;
+        dataStart = 0;
+        err = FIOFileInformation(fileName,&info);
+        dataSize = info.length;
+        if (rawRate <= 0) err = FIO_ERR_COMMAND;
+    }
+    if (err == 0) err = FIOGetSetPosition(streamHandle,dataStart);
+    if (err < 0) {
+        SNDStreamStop();
+        return err;
+    }
+    volume = _volume+1;isLooping = loop;
+    step = (uint32_t)(((uint64_t)frameRate << 16) / SNDGetSampleFrequency());
+    tickFrames = frameRate/25+1;                                                    // Twice what a 50Hz tick plays
+    return SNDStreamSeek(0);
+}
+
+/**
+ * @brief      Move to a position in the stream, and (re)start playing. The
+ *             mixer empties the ring, then the following ticks fill it
+ *             from the new position.
+ *
+ * @param[in]  frame  Sample frame to move to
+ *
+ * @return     0 or error code
+ */
+int SNDStreamSeek(int frame) {
+    if (streamHandle < 0) return FIO_ERR_HANDLE;
+    __atomic_store_n(&seekPending,true,__ATOMIC_RELEASE);                           // Nothing more is filled until the mixer has
+    int frameSize = channels*bytesPerSample;                                        // emptied the ring.
+    frame = max(0,min(frame,dataSize/frameSize));
+    int err = FIOGetSetPosition(streamHandle,dataStart+frame*frameSize);
+    if (err < 0) {
+        isPlaying = false;
+        return err;
+    }
+    framesRead = frame;endOfFile = false;fillLength = 0;
+    isPlaying = true;
+    return 0;
+}
+
+/**
+ * @brief      Check if the stream is playing
+ *
+ * @return     true if playing
+ */
+bool SNDStreamIsPlaying(void) {
+    return isPlaying && (seekPending || !finished);
+}
+
+/**
+ * @brief      Get the number of times the mixer has found the ring empty.
+ *
+ * @return     Underrun count, since starting.
+ */
+uint32_t SNDStreamUnderruns(void) {
+    return underruns;
+}
@@ -14,12 +14,16 @@
 #define CHANNEL_COUNT   (4)
 
 struct _ChannelStatus {
-    int limit;
-    int wrapper;
-    int state;
+    uint32_t phase;                                                                 // Position in the cycle, 2^32 is one cycle.
+    uint32_t step;                                                                  // Added to phase every sample.
+    uint16_t lfsr;                                                                  // Noise shift register.
     int soundType;
     int volume;
-    int samplePos;
+    const int8_t *data;                                                             // Sample data, NULL if none
+    uint32_t length;                                                                // Sample length, 16.16
+    uint32_t loopLength;                                                            // Sample loop length 16.16, 0 if not looped
+    const int8_t *waveData;                                                         // Wavetable data, NULL if none
+    uint32_t waveLength;                                                            // Wavetable length in samples
 } audio[CHANNEL_COUNT];
 
 
@@ -43,56 +47,126 @@ int SNDGetChannelCount(void) {
  * @brief      Mute all channels
  */
 void SNDMuteAllChannels(void) {
+    SNDLockMixer();
     for (int i = 0;i < CHANNEL_COUNT;i++) {
         struct _ChannelStatus *cs = &audio[i];
-        cs->limit = cs->wrapper = cs->state = cs->soundType = cs->volume = 0;
+        cs->phase = cs->step = 0;cs->soundType = cs->volume = 0;
+        cs->lfsr = 0xACE1;
+        cs->data = NULL;cs->length = cs->loopLength = 0;
+        cs->waveData = NULL;cs->waveLength = 0;
     }
+    SNDUnlockMixer();
 }
 
 
 //
-//              Get the next sample for the driver provided hardware rate.
+//              Render blocks of samples for the driver provided hardware rate. The mixer runs in the
+//              DMA interrupt on the hardware and on the audio thread in the simulator, so the functions
+//              which change a channel hold it off with SNDLockMixer() while they do.
 //
 
+#define SND_MIX_CHUNK   (64)                                                        // Samples mixed at a time
 
 /**
- * @brief      Get the next sound sample
+ * @brief      Mix one channel into the mixing buffer
  *
- * @param[in]  channel  dummy ?.
- *
- * @return     Sound level -128 .. 127
+ * @param      cs     Channel to mix
+ * @param      mix    Mixing buffer
+ * @param[in]  count  Number of samples
  */
-int8_t SNDGetChannelSample(int channel) {
-
-    static int activeCount = 0;
-
-    int level = 0;                                                                  // Summative limit
-    int channelsActive = activeCount;                                               // We have a very simple form of AGC, more than one channel scales volume
-    activeCount = 0;                                                                // Reset the count
-
-    for (int i = 0;i < CHANNEL_COUNT;i++) {                                         // Scan the channels
-        struct _ChannelStatus *cs = &audio[i];
-        if (cs->volume != 0) {                                                      // Channel on.
-            activeCount++;                                                          // Bump active count
-            if (cs->wrapper-- == 0) {                                               // Time to change the output level.
-                cs->wrapper = cs->limit;                                            // Fix up the new limit.
-                cs->state ^= 0xFF;
-                switch (cs->soundType) {
-                    case SNDTYPE_NOISE:
-                        level += (rand() & 0xFF)-0x80;
-                        break;
-                    default:                                                        // Square wave
-                        level += cs->state ? cs->volume : -cs->volume;break;
+static void _SNDMixChannel(struct _ChannelStatus *cs,int16_t *mix,int count) {
+    uint32_t phase = cs->phase;                                                     // Working copies in registers
+    uint32_t step = cs->step;
+    int volume = cs->volume;
+    if (cs->soundType == SNDTYPE_SAMPLE) {                                          // PCM sample, phase is 16.16 position
+        const int8_t *data = cs->data;
+        uint32_t length = cs->length;
+        volume++;                                                                   // So 127 plays samples unchanged.
+        for (int i = 0;i < count;i++) {
+            mix[i] += (data[phase >> 16] * volume) >> 7;
+            if (length - phase <= step) {                                           // Reaches the end, phase + step may not fit.
+                if (cs->loopLength == 0) {                                          // Not looped, silence the channel.
+                    cs->volume = 0;
+                    break;
                 }
+                uint32_t over = step - (length - phase);                            // Past the end, back into the loop
+                phase = length - cs->loopLength + over % cs->loopLength;
+            } else {
+                phase += step;
+            }
+        }
+    } else if (cs->soundType == SNDTYPE_WAVETABLE) {                                // Wavetable, one cycle of the waveform
+        const int8_t *data = cs->waveData;
+        uint32_t length = cs->waveLength;
+        volume++;
+        for (int i = 0;i < count;i++) {
+            mix[i] += (data[((phase >> 16) * length) >> 16] * volume) >> 7;
+            phase += step;
+        }
+    } else if (cs->soundType == SNDTYPE_NOISE) {                                    // Noise, new level every half cycle
+        uint32_t lfsr = cs->lfsr;
+        int level = (lfsr & 1) ? volume : -volume;
+        step = step << 1;
+        for (int i = 0;i < count;i++) {
+            uint32_t last = phase;
+            phase += step;
+            if (phase < last) {                                                     // Wrapped, clock the 16 bit Galois LFSR
+                lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB400);
+                level = (lfsr & 1) ? volume : -volume;
             }
+            mix[i] += level;
+        }
+        cs->lfsr = lfsr;
+    } else {                                                                        // Square wave, high for the first half cycle.
+        for (int i = 0;i < count;i++) {
+            mix[i] += ((int32_t)phase < 0) ? -volume : volume;
+            phase += step;
         }
     }
-    if (channelsActive > 1) {                                                       // If >= 2 channels scale output by 75% to reduce clipping.
-        level = level * 3 / 4;
+    cs->phase = phase;
+}
+
+/**
+ * @brief      Render a block of samples
+ *
+ * @param      out   Buffer for samples -128 .. 127
+ * @param[in]  n     Number of samples to render
+ */
+void SNDRenderBlock(int8_t *out,int n) {
+    int16_t mix[SND_MIX_CHUNK];
+    while (n > 0) {
+        int count = min(n,SND_MIX_CHUNK);
+        int channelsActive = 0;                                                     // We have a very simple form of AGC, more than one channel scales volume
+        memset(mix,0,count*sizeof(int16_t));
+        for (int i = 0;i < CHANNEL_COUNT;i++) {                                     // Mix each active channel.
+            if (audio[i].volume != 0) {
+                channelsActive++;
+                _SNDMixChannel(&audio[i],mix,count);
+            }
+        }
+        if (SNDStreamMix(mix,count)) channelsActive++;                              // Any file being streamed.
+        int scale = (channelsActive > 1) ? 3 : 4;                                   // If >= 2 channels scale output by 75% to reduce clipping.
+        for (int i = 0;i < count;i++) {
+            int level = mix[i] * scale / 4;
+            if (level < -127) level = -127;                                         // Clip into range
+            if (level > 127) level = 127;
+            *out++ = level;
+        }
+        n -= count;
     }
-    if (level < -127) level = -127;                                                 // Clip into range
-    if (level > 127) level = 127;
-    return level;
+}
+
+/**
+ * @brief      Get the next sound sample, a block of one sample.
+ *
+ * @param[in]  channel  dummy ?.
+ *
+ * @return     Sound level -128 .. 127
+ */
+int8_t SNDGetChannelSample(int channel) {
+    int8_t sample;
+    SNDRenderBlock(&sample,1);
+    return sample;
 }
 
 
@@ -109,14 +183,100 @@ int8_t SNDGetChannelSample(int channel) {
  */
 void SNDUpdate(int channel,SNDCHANNEL *c) {
     if (channel >= CHANNEL_COUNT) return;
+    if (c->type == SNDTYPE_SAMPLE) return;                                          // Samples are started by SNDPlaySample()
+    SNDLockMixer();
+    if (c->type == SNDTYPE_WAVETABLE && audio[channel].waveData == NULL) {          // No waveform set.
+        SNDUnlockMixer();
+        return;
+    }
     if (c->frequency != 0) {
-        audio[channel].limit = SNDGetSampleFrequency()/c->frequency/2;
-        audio[channel].wrapper = 0;
+        audio[channel].step = (uint32_t)(((uint64_t)c->frequency << 32) / SNDGetSampleFrequency());
+        audio[channel].phase = 0;
         audio[channel].soundType = c->type;
         audio[channel].volume = c->volume;
-        audio[channel].samplePos = 0;
+        if (audio[channel].lfsr == 0) audio[channel].lfsr = 0xACE1;                 // LFSR must never be zero.
     } else {
         audio[channel].volume = 0;
     }
+    SNDUnlockMixer();
+}
+
+/**
+ * @brief      Change the sound on a channel without restarting the waveform,
+ *             used by envelopes which change pitch and volume as a note
+ *             plays.
+ *
+ * @param[in]  channel      The channel
+ * @param[in]  type         Sound type, not SNDTYPE_SAMPLE
+ * @param[in]  frequency16  Frequency in 1/16ths of a Hz
+ * @param[in]  volume       Volume 0-127
+ */
+void SNDAdjustChannel(int channel,int type,int frequency16,int volume) {
+    if (channel >= CHANNEL_COUNT || type == SNDTYPE_SAMPLE) return;
+    SNDLockMixer();
+    if (type == SNDTYPE_WAVETABLE && audio[channel].waveData == NULL) volume = 0;     // No waveform set.
+    audio[channel].step = (uint32_t)(((uint64_t)frequency16 << 28) / SNDGetSampleFrequency());
+    audio[channel].soundType = type;
+    if (audio[channel].lfsr == 0) audio[channel].lfsr = 0xACE1;
+    audio[channel].volume = volume;
+    SNDUnlockMixer();
+}
+
+//
+//                              Samples and wavetables
+//
+
+/**
+ * @brief      Play an 8 bit signed PCM sample on a channel. The data is not
+ *             copied, so it must remain valid while the channel is playing.
+ *
+ * @param[in]  channel     The channel
+ * @param[in]  data        Sample data
+ * @param[in]  length      Length in samples, at most 65535
+ * @param[in]  loopStart   Sample to loop back to at the end, -1 plays once
+ * @param[in]  sampleRate  Playback rate in Hz, this sets the pitch
+ * @param[in]  volume      Volume 0-127
+ */
+void SNDPlaySample(int channel,const int8_t *data,int length,int loopStart,int sampleRate,int volume) {
+    if (channel >= CHANNEL_COUNT) return;
+    struct _ChannelStatus *cs = &audio[channel];
+    SNDLockMixer();
+    cs->volume = 0;                                                                 // Stop it while we change it
+    if (data == NULL || length <= 0 || sampleRate <= 0) {
+        SNDUnlockMixer();
+        return;
+    }
+    length = min(length,0xFFFF);
+    cs->data = data;
+    cs->length = (uint32_t)length << 16;
+    cs->loopLength = (loopStart >= 0 && loopStart < length) ? (uint32_t)(length-loopStart) << 16 : 0;
+    cs->step = (uint32_t)(((uint64_t)sampleRate << 16) / SNDGetSampleFrequency());
+    cs->phase = 0;
+    cs->soundType = SNDTYPE_SAMPLE;
+    cs->volume = volume;
+    SNDUnlockMixer();
 }
 
+/**
+ * @brief      Set the waveform used by a channel when it plays
+ *             SNDTYPE_WAVETABLE, one cycle of the waveform. The data is not
+ *             copied. It is kept apart from any sample, so a sample playing
+ *             on the channel is not affected.
+ *
+ * @param[in]  channel  The channel
+ * @param[in]  data     Waveform data, one cycle
+ * @param[in]  length   Length in samples, 1-65535
+ */
+void SNDSetWaveform(int channel,const int8_t *data,int length) {
+    if (channel >= CHANNEL_COUNT) return;
+    struct _ChannelStatus *cs = &audio[channel];
+    SNDLockMixer();                                                                 // Data and length change together.
+    if (data == NULL || length <= 0) {
+        if (cs->soundType == SNDTYPE_WAVETABLE) cs->volume = 0;                     // Nothing to play.
+        cs->waveData = NULL;
+    } else {
+        cs->waveData = data;
+        cs->waveLength = min(length,0xFFFF);
+    }
+    SNDUnlockMixer();
+}
@@ -0,0 +1,55 @@
+/**
+ * @file       profile.c
+ *
+ * @brief      Profiling counters, maintained on the simulator only.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "common.h"
+
+#ifndef PICO
+uint32_t prfCounters[PRF_COUNTERS];
+static uint8_t writeMap[PRF_WRITE_MAP_SIZE];                                    // Writes to each bitplane byte offset.
+
+/**
+ * @brief      Record writes to bitplane bytes, counts saturate at 255
+ *
+ * @param[in]  offset  Byte offset in the bitplane
+ * @param[in]  count   Number of consecutive bytes written
+ */
+void PRFMarkWriteRange(int offset,int count) {
+    while (count-- > 0) {
+        if (offset >= 0 && offset < PRF_WRITE_MAP_SIZE && writeMap[offset] != 0xFF) writeMap[offset]++;
+        offset++;
+    }
+}
+
+/**
+ * @brief      Access the write map, the reader clears it.
+ *
+ * @return     Array of write counts, one per bitplane byte offset.
+ */
+uint8_t *PRFGetWriteMap(void) {
+    return writeMap;
+}
+#endif
+
+/**
+ * @brief      Read a profiling counter. These wrap round and are always zero
+ *             on the hardware.
+ *
+ * @param[in]  counter  The counter (PRF_xxx)
+ *
+ * @return     Current value
+ */
+uint32_t PRFReadCounter(int counter) {
+    #ifdef PICO
+    return 0;
+    #else
+    return prfCounters[counter];
+    #endif
+}
@@ -15,6 +15,7 @@ static inline void _VDUDrawBitmap1(void);
 static inline void _VDUDrawBitmap3(void);
 static inline void _VDUDrawBitmap6(void);
 static inline void _VDUDrawBitmap(void);
+static inline void _VDUWriteBitmap(void);
 static int _VDUAReadPixelDirect(void);
 static void _VDUAValidate(void);
 
@@ -114,8 +115,9 @@ void VDUAHorizLine(int x1,int x2,int y) {
     //
     //      While on a byte boundary, if there are enough pixels, do whole bytes. I did consider doing it in longs at this point.
     //
+    PRFCount(PRF_SPAN_BYTES,pixelCount/ppb);
     while (pixelCount >= ppb) {                                                     // Now do it byte chunks.
-        bitMask = 0xFF;_VDUDrawBitmap();                                            // This does the line in whole bytes.
+        bitMask = 0xFF;_VDUWriteBitmap();                                           // This does the line in whole bytes.
         pl0++;pl1++;pl2++;                                                          // Advance pointer
         pixelCount -= ppb;                                                          // 8 fewer pixels
         xPixel += ppb;                                                              // Keep the position up to date, doesn't really matter.
@@ -276,10 +278,21 @@ void VDUALine(int x0, int y0, int x1, int y1) {
 }
 
 /**
- * @brief      Draw bitmap dispatched
+ * @brief      Draw bitmap dispatched, counted as a pixel write
  */
 static inline void _VDUDrawBitmap(void) {
     if (!dataValid) return;                                                         // Not valid drawing.
+    PRFCount(PRF_PIXEL_WRITES,1);
+    _VDUWriteBitmap();
+}
+
+/**
+ * @brief      Draw bitmap dispatched, spans use this as they count their
+ *             bytes themselves.
+ */
+static inline void _VDUWriteBitmap(void) {
+    if (!dataValid) return;                                                         // Not valid drawing.
+    PRFMarkWrite(pl0-_dmi->bitPlane[0],1);
     if (_dmi->bitPlaneCount == 1) {                                                 // Draw the bitmap.
         _VDUDrawBitmap1();
     } else if (_dmi->bitPlaneDepth == 2) {
@@ -132,9 +132,11 @@ static void _GFXDrawEllipse(bool fill) {
     d1 = (ry * ry) - (rx * rx * ry) + (0.25 * rx * rx);
     dx = 2 * ry * ry * x;
     dy = 2 * rx * rx * y;
+    PRFCount(PRF_FLOAT_OPS,12);
 
     while (dx < dy)
     {
+        PRFCount(PRF_FLOAT_OPS,8);                                              // Compare, updates and conversions
         if (fill) {
             _GFXLinePart(x,y);
         } else {
@@ -157,9 +159,11 @@ static void _GFXDrawEllipse(bool fill) {
     d2 = ((ry * ry) * ((x + 0.5) * (x + 0.5))) +
          ((rx * rx) * ((y - 1) * (y - 1))) -
           (rx * rx * ry * ry);
+    PRFCount(PRF_FLOAT_OPS,10);
 
     while (y >= 0)
     {
+        PRFCount(PRF_FLOAT_OPS,8);
         if (fill) {
             _GFXLinePart(x,y);
         } else {
@@ -144,6 +144,7 @@ int  VDUReadPixel(int x,int y) {
  */
 void VDUPlotCommand(int cmd,int x,int y) {
 
+    PRFCount(PRF_PLOT_COMMANDS,1);
     //
     //      Handle offset (e.g. command bit 2 is zero)
     //
@@ -135,6 +135,8 @@ static void _VDURenderCharacter(int x,int y,int c) {
         for (int yChar = 0;yChar < 8;yChar++) {                                     // Each line in a bit plane.
             uint8_t pixels = VDUGetCharacterLineData(c,yChar);                      // Get the character line data.
             uint8_t *p = dmi->bitPlane[plane] + (y*8+yChar)*dmi->bytesPerLine;      // Position in bitmap.
+            if (plane == 0) PRFMarkWrite((y*8+yChar)*dmi->bytesPerLine+x*dmi->bitPlaneDepth,dmi->bitPlaneDepth);
+            PRFCount(PRF_GLYPH_BYTES,dmi->bitPlaneDepth);
             if (dmi->bitPlaneDepth == 1) {                                          // Handle 8 bits per bitmap (2,8 colours)
                 *(p+x) = _VDUMapToBitplaneByte(pixels,plane);
             } else {                                                                // Handle 4 bits per bitmap (64 colours)
@@ -260,6 +262,8 @@ static void _VDUScroll(int yFrom,int yTo,int yTarget,int yClear,int xLeft, int x
             f = f + xLeft * bytesPerCharacter;                                      // Start of the copy block
             t = t + xLeft * bytesPerCharacter;
             memcpy(t,f,copySize);                                                   // Copy it
+            if (i == 0) PRFMarkWrite(t-dmi->bitPlane[0],copySize);
+            PRFCount(PRF_SCROLL_BYTES,copySize);
         }        
         yFrom += dir;yTo += dir;                                                    // Scroll the line down.
     }
@@ -294,6 +298,8 @@ static void _VDUScrollH(int xLeft,int xRight,int dir,int yTop, int yBottom)
         for (int i = 0;i < dmi->bitPlaneCount;i++) {                                // For each bitplane
             uint8_t *la = dmi->bitPlane[i] + dmi->bytesPerLine * y;              // Start Line from
             memmove(la+xTo,la+xFrom,copySize);                                              // Copy it
+            if (i == 0) PRFMarkWrite(la+xTo-dmi->bitPlane[0],copySize);
+            PRFCount(PRF_SCROLL_BYTES,copySize);
         }        
     // Scroll the line left/right.
     }
@@ -342,6 +348,7 @@ void VDUScrollRect(int ext, int direction)
  * @param[in]  c     Character to output (non control)
  */
 void VDUWriteText(uint8_t c) {
+    PRFCount(PRF_TEXT_CHARS,1);
     _VDURenderCharacter(xCursor+xLeft,yCursor+yTop,c);                              // Write character
     VDUWrite(9);                                                                    // Move forward.
 }
@@ -391,6 +398,7 @@ static void _VDUDrawCursor(bool isVisible) {
     for (int plane = 0;plane < dmi->bitPlaneCount;plane++) {        
       uint8_t *p = dmi->bitPlane[plane] + (dmi->bytesPerLine * 8 * (yCursor+yTop)) + ((xCursor+xLeft) * (is64Bit ? 2 : 1));
         for (int y = 0;y < 8;y++) {
+            if (plane == 0) PRFMarkWrite(p-dmi->bitPlane[0],is64Bit ? 2 : 1);
             *p ^= 0xFF;if (is64Bit) *(p+1) ^= 0xFF;
             p += dmi->bytesPerLine;
         }
@@ -111,6 +111,7 @@ static void drawFilledTriangle() {
         Vertice vt4;
         vt4.x =  (int)(vt1.x + ((float)(vt2.y - vt1.y) / (float)(vt3.y - vt1.y)) * (vt3.x - vt1.x));
         vt4.y = vt2.y;
+        PRFCount(PRF_FLOAT_OPS,6);                                      /* Conversions, divide, multiply and add */
         fillBottomFlatTriangle(vt1, vt2, vt4);
         fillTopFlatTriangle(vt2, vt4, vt3);
     }
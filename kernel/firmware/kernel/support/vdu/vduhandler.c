@@ -66,6 +66,7 @@ void VDUWrite(int c) {
     int x1,y1,x2,y2;
 
     if (DVIGetModeInformation() == NULL) return;                                    // Check screen is actually on.
+    PRFCount(PRF_VDU_BYTES,1);
 
     if (_vduRequired == 0) {                                                        // New command ?
         _vduPendingCommand = c;                                                     // The pending command.
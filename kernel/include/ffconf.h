@@ -0,0 +1,78 @@
+/*---------------------------------------------------------------------------/
+/  Configuration of FatFs R0.15 (the copy in tinyUSB 0.17.0) for Arturo.
+/
+/  The build copies the FatFs sources next to this file, as ff.h includes
+/  "ffconf.h" from its own directory, so this one is used rather than the
+/  tinyUSB example's. The simulator's FATFS=1 build uses it as well.
+/---------------------------------------------------------------------------*/
+
+#define FFCONF_DEF	80286	/* Revision ID */
+
+/*---------------------------------------------------------------------------/
+/ Function Configurations
+/---------------------------------------------------------------------------*/
+
+#define FF_FS_READONLY	0
+#define FF_FS_MINIMIZE	0
+#define FF_USE_FIND		0
+#define FF_USE_MKFS		0
+#define FF_USE_FASTSEEK	0
+#define FF_USE_EXPAND	1		/* f_expand(), used by FSYSPreallocate() when saving whole files */
+#define FF_USE_CHMOD	0
+#define FF_USE_LABEL	0
+#define FF_USE_FORWARD	0
+
+#define FF_USE_STRFUNC	0
+#define FF_PRINT_LLI	0
+#define FF_PRINT_FLOAT	0
+#define FF_STRF_ENCODE	3
+
+/*---------------------------------------------------------------------------/
+/ Locale and Namespace Configurations
+/---------------------------------------------------------------------------*/
+
+#define FF_CODE_PAGE	437
+
+#define FF_USE_LFN		1		/* Long file names, static working buffer */
+#define FF_MAX_LFN		255
+#define FF_LFN_UNICODE	0
+#define FF_LFN_BUF		255
+#define FF_SFN_BUF		12
+
+#define FF_FS_RPATH		2		/* f_chdir(), f_chdrive() and f_getcwd(), fileio.c keeps its own too */
+
+/*---------------------------------------------------------------------------/
+/ Drive/Volume Configurations
+/---------------------------------------------------------------------------*/
+
+#define FF_VOLUMES		6		/* The drive is the USB device address, 1 to CFG_TUH_DEVICE_MAX (5) */
+#define FF_STR_VOLUME_ID	0
+#define FF_VOLUME_STRS		"RAM","NAND","CF","SD","SD2","USB","USB2","USB3"
+#define FF_MULTI_PARTITION	0
+
+#define FF_MIN_SS		512
+#define FF_MAX_SS		512		/* SEC_SECTOR_SIZE in sectorcache.h */
+
+#define FF_LBA64		0
+#define FF_MIN_GPT		0x10000000
+#define FF_USE_TRIM		0
+
+/*---------------------------------------------------------------------------/
+/ System Configurations
+/---------------------------------------------------------------------------*/
+
+#define FF_FS_TINY		0
+#define FF_FS_EXFAT		0
+
+#define FF_FS_NORTC		1		/* No clock, files are given this date */
+#define FF_NORTC_MON	1
+#define FF_NORTC_MDAY	1
+#define FF_NORTC_YEAR	2025
+
+#define FF_FS_NOFSINFO	0
+#define FF_FS_LOCK		0
+
+#define FF_FS_REENTRANT	0		/* Only called from one thread */
+#define FF_FS_TIMEOUT	1000
+
+/*--- End of configuration options ---*/
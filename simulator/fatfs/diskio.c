@@ -0,0 +1,135 @@
+/**
+ * @file       diskio.c
+ *
+ * @brief      FatFS disk interface for a disk image, used when the simulator
+ *             is built with FATFS=1. Like the hardware's usb_storage.c, sector
+ *             access goes through the sector cache.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+#include "ff.h"
+#include "diskio.h"
+
+static FATFS volume;
+static bool isMounted = false;
+
+/**
+ * @brief      Unmount the image, writing anything waiting, and show the disk
+ *             activity.
+ */
+void FATUnmount(void) {
+    if (!isMounted) return;
+    SECSTATISTICS st;
+    uint32_t commands,sectorsRead,sectorsWritten;
+    f_unmount("0:");
+    SECSync(0);
+    isMounted = false;
+    SECGetStatistics(&st);
+    DIMGetCounts(&commands,&sectorsRead,&sectorsWritten);
+    fprintf(stderr,"Disk image: %u transfers, %u sectors read, %u sectors written, %.3fs waiting\n",
+                            commands,sectorsRead,sectorsWritten,DIMGetWaitTime());
+    fprintf(stderr,"Sector cache: %u of %u reads hit, %u read ahead, largest transfer %u\n",
+                            st.hits,st.hits+st.misses,st.readAhead,st.largestTransfer);
+    DIMClose();
+}
+
+/**
+ * @brief      Open and mount a FAT disk image
+ *
+ * @param      imageName  The image file
+ *
+ * @return     true if mounted
+ */
+bool FATMount(char *imageName) {
+    if (!DIMOpen(imageName,0)) return false;
+    SECSetDevice(DIMTransfer,DIMWait,DIMSectorCount);
+    if (f_mount(&volume,"0:",1) != FR_OK) {
+        DIMClose();
+        return false;
+    }
+    isMounted = true;
+    atexit(FATUnmount);                                                             // Benchmarks exit() directly.
+    return true;
+}
+
+/**
+ * @brief      Get Disk status
+ *
+ * @param[in]  pdrv  The pdrv
+ *
+ * @return     DSTATUS object
+ */
+DSTATUS disk_status(BYTE pdrv) {
+    return (pdrv == 0 && DIMSectorCount(0) != 0) ? 0 : STA_NODISK;
+}
+
+/**
+ * @brief      Initialise a drive
+ *
+ * @param[in]  pdrv  The pdrv
+ *
+ * @return     DSTATUS object
+ */
+DSTATUS disk_initialize(BYTE pdrv) {
+    return disk_status(pdrv);
+}
+
+/**
+ * @brief      Read disk
+ *
+ * @param[in]  pdrv    The pdrv
+ * @param      buff    The buffer
+ * @param[in]  sector  The sector
+ * @param[in]  count   The count
+ *
+ * @return     DRESULT object
+ */
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
+    return SECRead(pdrv, sector, buff, count) == 0 ? RES_OK : RES_ERROR;
+}
+
+/**
+ * @brief      Write to disk
+ *
+ * @param[in]  pdrv    The pdrv
+ * @param[in]  buff    The buffer
+ * @param[in]  sector  The sector
+ * @param[in]  count   The count
+ *
+ * @return     DRESULT object
+ */
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
+    return SECWrite(pdrv, sector, buff, count) == 0 ? RES_OK : RES_ERROR;
+}
+
+/**
+ * @brief      Handle IODRV commands
+ *
+ * @param[in]  pdrv  The pdrv
+ * @param[in]  cmd   The command
+ * @param      buff  The buffer
+ *
+ * @return     The value requested.
+ */
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    switch (cmd) {
+        case CTRL_SYNC:
+            return SECSync(pdrv) == 0 ? RES_OK : RES_ERROR;
+        case GET_SECTOR_COUNT:
+            *((LBA_t *)buff) = DIMSectorCount(0);
+            return RES_OK;
+        case GET_SECTOR_SIZE:
+            *((WORD *)buff) = SEC_SECTOR_SIZE;
+            return RES_OK;
+        case GET_BLOCK_SIZE:
+            *((DWORD *)buff) = 1;  // 1 sector
+            return RES_OK;
+        default:
+            return RES_PARERR;
+    }
+}
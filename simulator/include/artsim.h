@@ -25,14 +25,57 @@ void SYSOpen(bool muteSound);
 int SYSPollUpdate(void);
 void SYSClose(void);
 void SYSRectangle(SDL_Rect *rc,int colour);
+void SYSRequestExit(int status);
 
 void RNDRender(SDL_Surface *surface);
+void RNDDecodeLine(int y,int *colours);
+int RNDGetPalette(int *colours);
+void RNDToggleHeatMap(void);
 int TMRReadTimerMS(void);
 void KBDProcessEvent(int scanCode,int modifiers,bool isDown);
 
 void CTLFindControllers(void);
+void CTLCheckControllers(void);
+
+bool SCROpen(char *fileName);
+bool SCRIsComplete(void);
+void SCRUpdate(void);
+
+bool CAPOpen(char *hashLogName,int interval);
+bool CAPWriteImage(char *fileName);
+uint64_t CAPHashDisplay(void);
+void CAPCaptureNext(void);
+void CAPEndFrame(void);
+void CAPClose(void);
+
+void HUDToggle(void);
+void HUDEndFrame(void);
+
+bool CSTOpen(char *logName);
+void CSTEndFrame(void);
+uint32_t CSTGetFrameCycles(void);
+unsigned int CSTGetBudgetPercent(void);
+void CSTClose(void);
+
+bool DIMOpen(char *fileName,int create);
+void DIMClose(void);
+uint32_t DIMSectorCount(uint8_t drive);
+int DIMTransfer(uint8_t drive,uint32_t sector,uint8_t *buffer,int count,bool isWrite);
+int DIMWait(uint8_t drive);
+void DIMGetCounts(uint32_t *pCommands,uint32_t *pRead,uint32_t *pWritten);
+void DIMSetLatency(int command,int sector);
+double DIMGetWaitTime(void);
+
+bool FATMount(char *imageName);
+void FATUnmount(void);
+
+int BENCHRun(char *name);
+bool BENCHUsesOwnImage(char *name);
+int BENCHRenderMusic(char *song,char *wavName);
 
 void SOUNDOpen(void);
 void SOUNDClose(void);
 void SOUNDPlay(void);
 void SOUNDStop(void);
+void SOUNDResample(int16_t *out,int count,int deviceRate);
+uint32_t SOUNDGetUnderruns(void);
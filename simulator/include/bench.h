@@ -0,0 +1,37 @@
+/**
+ * @file       bench.h
+ *
+ * @brief      Header file, host benchmarks
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#pragma once
+
+#include <stdarg.h>
+
+double BENCHTime(void);
+bool BENCHReport(bool isOk,const char *format,...);
+
+int BENCHSound(void);                                                           // benchsound.c
+int BENCHTone(void);
+int BENCHSamples(void);
+int BENCHQueue(void);
+int BENCHStream(void);
+int BENCHResample(void);
+
+int BENCHKeyboard(void);                                                        // benchinput.c
+int BENCHEvents(void);
+int BENCHHID(void);
+
+int BENCHFileIO(void);                                                          // benchfiles.c
+int BENCHDirectory(void);
+int BENCHWorkingDirectory(void);
+int BENCHAsync(void);
+
+int BENCHHeatMap(void);                                                         // benchdisplay.c
+
+int BENCHSectorCache(void);                                                     // benchstorage.c
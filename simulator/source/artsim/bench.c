@@ -0,0 +1,101 @@
+/**
+ * @file       bench.c
+ *
+ * @brief      Host benchmarks, run with artsim -b <name>, and music rendering
+ *             to WAV files with artsim -r, without opening the display. The
+ *             benchmarks themselves are in bench<subsystem>.c
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+#include "bench.h"
+
+typedef int (*BENCHFUNCTION)(void);
+
+/**
+ * @brief      Get elapsed time
+ *
+ * @return     Time in seconds, from the high resolution timer.
+ */
+double BENCHTime(void) {
+    return (double)SDL_GetPerformanceCounter()/(double)SDL_GetPerformanceFrequency();
+}
+
+/**
+ * @brief      Report the result of a check, the description followed by ok
+ *             or FAIL.
+ *
+ * @param[in]  isOk    Result of the check
+ * @param[in]  format  printf() format of the description
+ * @param[in]  ...     Description values
+ *
+ * @return     isOk, so results can be combined.
+ */
+bool BENCHReport(bool isOk,const char *format,...) {
+    va_list args;
+    va_start(args,format);
+    vprintf(format,args);
+    va_end(args);
+    printf(" %s\n",isOk ? "ok":"FAIL");
+    return isOk;
+}
+
+static struct _BenchList {
+    char *name;
+    BENCHFUNCTION function;
+    char *description;
+} benchmarks[] = {
+    { "sectorcache",BENCHSectorCache,"sector cache against a disk image, hit rate and transfer sizes" },
+    { "sound",BENCHSound,"sound synthesis, samples/second and CPU share" },
+    { "resample",BENCHResample,"check tone pitch through the simulator's resampler" },
+    { "samples",BENCHSamples,"four sample channels, samples/second and CPU share" },
+    { "events",BENCHEvents,"input event queue order, merging, overflow and cost" },
+    { "async",BENCHAsync,"asynchronous reads and writes, against blocking reads" },
+    { "cwd",BENCHWorkingDirectory,"changing directory, relative names, long names and relative open time" },
+    { "directory",BENCHDirectory,"directory listing with and without FIOReadDirectoryEx" },
+    { "fileio",BENCHFileIO,"buffered file reads by line, CR-LF saves and whole file load and save" },
+    { "heatmap",BENCHHeatMap,"check clears, scrolls and the cursor are marked in the write map" },
+    { "hid",BENCHHID,"HID keyboard report sequences and time per report" },
+    { "keyboard",BENCHKeyboard,"keyboard queue order, overflow and dequeue time" },
+    { "queue",BENCHQueue,"check queued note timing and envelopes" },
+    { "stream",BENCHStream,"file read rate against streaming needs, stream playback" },
+    { "tone",BENCHTone,"check tone generator pitch, levels and sample playback" },
+    { NULL,NULL,NULL }
+};
+
+/**
+ * @brief      Check if a benchmark uses a disk image of its own, so the
+ *             simulator's image must not be mounted while it runs.
+ *
+ * @param      name  Name of the benchmark
+ *
+ * @return     true if it opens its own image.
+ */
+bool BENCHUsesOwnImage(char *name) {
+    return strcmp(name,"sectorcache") == 0;
+}
+
+/**
+ * @brief      Run a benchmark
+ *
+ * @param      name  Name of the benchmark
+ *
+ * @return     Exit status, 2 if not known.
+ */
+int BENCHRun(char *name) {
+    FIOInitialise();                                                            // Some use the file system.
+    for (int i = 0;benchmarks[i].name != NULL;i++) {
+        if (strcmp(benchmarks[i].name,name) == 0) {
+            return (*benchmarks[i].function)();
+        }
+    }
+    fprintf(stderr,"Benchmarks:\n");
+    for (int i = 0;benchmarks[i].name != NULL;i++) {
+        fprintf(stderr,"    %-10s %s\n",benchmarks[i].name,benchmarks[i].description);
+    }
+    return 2;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file       benchdisplay.c
+ *
+ * @brief      Display checks, the bitplane write map.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+#include "bench.h"
+
+/**
+ * @brief      Count the bitplane bytes written since the write map was last
+ *             cleared, and clear it.
+ *
+ * @param[in]  from  First byte offset to count
+ * @param[in]  to    Byte offset after the last
+ *
+ * @return     Number of bytes written at least once
+ */
+static int _BENCHCountWrites(int from,int to) {
+    uint8_t *map = PRFGetWriteMap();
+    int count = 0;
+    for (int i = from;i < to;i++) count += (map[i] != 0);
+    memset(map,0,PRF_WRITE_MAP_SIZE);
+    return count;
+}
+
+/**
+ * @brief      Heat map checks, every byte written by clearing the screen,
+ *             scrolling and clearing the graphics window is marked in each
+ *             mode, as is the cursor.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHHeatMap(void) {
+    static const int modes[] = { DVI_MODE_640_240_8,DVI_MODE_320_240_8,DVI_MODE_640_480_2,
+                                 DVI_MODE_320_240_64,DVI_MODE_320_256_8 };
+    bool ok = true;
+    for (int m = 0;m < (int)(sizeof(modes)/sizeof(modes[0]));m++) {
+        VDUWrite(22);VDUWrite(modes[m]);
+        struct DVIModeInformation *dmi = DVIGetModeInformation();
+        int size = dmi->bytesPerLine*dmi->height;                               // Bytes in a bitplane
+        int line = dmi->bytesPerLine*8;                                         // Bytes in a text line
+        _BENCHCountWrites(0,0);
+        VDUWrite(12);VDUHideCursor();
+        int cls = _BENCHCountWrites(0,size);
+        for (int i = 0;i < dmi->height/8;i++) { VDUWrite('A');VDUWrite(13);VDUWrite(10); }
+        VDUHideCursor();_BENCHCountWrites(0,0);
+        VDUWrite(10);VDUHideCursor();                                           // Scroll, clearing the bottom line
+        int scroll = _BENCHCountWrites(size-line,size);
+        VDUWrite(16);
+        int clg = _BENCHCountWrites(0,size);
+        VDUHideCursor();_BENCHCountWrites(0,0);
+        VDUShowCursor();
+        int cursor = _BENCHCountWrites(0,size);
+        bool modeOk = cls == size && scroll == line && clg == size && cursor == 8*dmi->bitPlaneDepth;
+        ok = BENCHReport(modeOk,"Mode %d: clear %d/%d, scroll clear %d/%d, CLG %d/%d, cursor %d",modes[m],
+                                    cls,size,scroll,line,clg,size,cursor) && ok;
+    }
+    VDUWrite(22);VDUWrite(DVI_MODE_640_240_8);
+    return ok ? 0 : 1;
+}
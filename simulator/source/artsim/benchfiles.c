@@ -0,0 +1,451 @@
+/**
+ * @file       benchfiles.c
+ *
+ * @brief      File system benchmarks and checks, buffered and asynchronous
+ *             file I/O, directories and the working directory.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+#include "bench.h"
+
+/**
+ * @brief      Read a file a line at a time, as READ-LINE (and so INCLUDED)
+ *             does, with or without a buffer.
+ *
+ * @param      name      File name
+ * @param      buffer    Buffer, NULL for none
+ * @param[in]  size      Size of buffer
+ * @param      checksum  Sum of the characters read
+ *
+ * @return     Number of lines, -1 if it could not be read
+ */
+static int _BENCHReadLines(char *name,void *buffer,int size,uint32_t *checksum) {
+    char line[130];
+    int lines = 0,n;
+    int h = FIOOpen(name);
+    if (h < 0) return -1;
+    if (buffer != NULL) FIOSetBuffer(h,buffer,size);
+    *checksum = 0;
+    while ((n = FIOReadLine(h,line,sizeof(line))) > 0) {
+        for (int i = 0;i < n;i++) *checksum = *checksum*31+line[i];
+        lines++;
+    }
+    FIOClose(h);
+    return (n == FIO_ERR_EOF) ? lines : -1;
+}
+
+/**
+ * @brief      Save text with CR-LF line endings a character at a time, as the
+ *             editor does, with or without a buffer.
+ *
+ * @param      name    File name
+ * @param      text    Text, with LF endings
+ * @param[in]  length  Length of text
+ * @param      buffer  Buffer, NULL for none
+ * @param[in]  size    Size of buffer
+ *
+ * @return     true if saved
+ */
+static bool _BENCHSaveCRLF(char *name,char *text,int length,void *buffer,int size) {
+    FIODeleteFile(name);
+    FIOCreateFile(name);
+    int h = FIOOpen(name);
+    if (h < 0) return false;
+    if (buffer != NULL) FIOSetBuffer(h,buffer,size);
+    for (int i = 0;i < length;i++) {
+        if (buffer == NULL) {                                                   // The old way, two writes a character
+            if (text[i] == '\n') FIOWrite(h,"\r",1);
+            FIOWrite(h,text+i,1);
+        } else {
+            if (text[i] == '\n') FIOWriteByte(h,'\r');
+            FIOWriteByte(h,text[i]);
+        }
+    }
+    return FIOClose(h) == FIO_OK;
+}
+
+/**
+ * @brief      Buffered file I/O checks, reading lines and saving CR-LF text
+ *             with and without a buffer, and mixing reads, writes and seeks
+ *             on a buffered file.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHFileIO(void) {
+    static char text[100*1024];
+    static uint8_t buffer[1024],compare[sizeof(text)*3];
+    char *name = "__fileio.txt",*name2 = "__fileio2.txt";
+    bool ok = true;
+    int length = 0,lineCount = 0;
+    while (length < (int)sizeof(text)-100) {                                    // Forth like source, LF endings
+        length += sprintf(text+length,": WORD%d ( n -- n ) DUP %d + SWAP DROP ; \\ line %d\n",
+                                                        lineCount,lineCount*7,lineCount);
+        lineCount++;
+    }
+
+    double start = BENCHTime();                                                 // Save it, CR-LF.
+    bool saveOk = _BENCHSaveCRLF(name2,text,length,NULL,0);
+    double unbuffered = BENCHTime()-start;
+    start = BENCHTime();
+    saveOk = _BENCHSaveCRLF(name,text,length,buffer,sizeof(buffer)) && saveOk;
+    double buffered = BENCHTime()-start;
+    FIOInfo info,info2;
+    int h1 = FIOOpen(name),h2 = FIOOpen(name2);                                 // Same result both ways ?
+    int n1 = FIORead(h1,compare,sizeof(compare)/2),n2 = FIORead(h2,compare+sizeof(compare)/2,sizeof(compare)/2);
+    FIOClose(h1);FIOClose(h2);
+    saveOk = saveOk && FIOFileInformation(name,&info) == 0 && FIOFileInformation(name2,&info2) == 0 &&
+                info.length == length+lineCount && n1 == n2 && n1 == info.length &&
+                memcmp(compare,compare+sizeof(compare)/2,n1) == 0;
+    ok = BENCHReport(saveOk,"CR-LF save of %d bytes, %.2fms unbuffered, %.2fms buffered (%.1fx)",info.length,
+                        unbuffered*1000,buffered*1000,unbuffered/buffered) && ok;
+
+    uint32_t sum1,sum2;                                                         // Read it back a line at a time
+    start = BENCHTime();
+    int lines1 = _BENCHReadLines(name,NULL,0,&sum1);
+    unbuffered = BENCHTime()-start;
+    start = BENCHTime();
+    int lines2 = _BENCHReadLines(name,buffer,sizeof(buffer),&sum2);
+    buffered = BENCHTime()-start;
+    uint32_t expected = 0;
+    for (int i = 0;i < length;i++) expected = expected*31+text[i];
+    bool readOk = lines1 == lineCount && lines2 == lineCount && sum1 == expected && sum2 == expected;
+    ok = BENCHReport(readOk,"Read %d lines, %.2fms unbuffered, %.2fms buffered (%.1fx)",lines2,
+                        unbuffered*1000,buffered*1000,unbuffered/buffered) && ok;
+
+    h1 = FIOOpen(name);                                                         // Mix reads, writes and seeks
+    FIOSetBuffer(h1,buffer,64);
+    uint8_t data[100];
+    bool mixOk = FIORead(h1,data,10) == 10 && memcmp(data,text,10) == 0 &&
+                    FIOGetSetPosition(h1,-1) == 10;
+    mixOk = mixOk && FIOWrite(h1,"0123456789",10) == FIO_OK && FIOGetSetPosition(h1,-1) == 20;
+    mixOk = mixOk && FIOReadByte(h1) == text[20] && FIOGetSetPosition(h1,5) == 21;
+    mixOk = mixOk && FIORead(h1,data,20) == 20 && memcmp(data,text+5,5) == 0 && memcmp(data+5,"0123456789",10) == 0;
+    mixOk = mixOk && FIOGetSetPosition(h1,info.length-3) == 25 && FIORead(h1,data,100) == 3 &&
+                    FIOReadByte(h1) == FIO_ERR_EOF;
+    FIOClose(h1);
+    h1 = FIOOpen(name);                                                         // Written when closed ?
+    mixOk = mixOk && FIORead(h1,data,20) == 20 && memcmp(data+10,"0123456789",10) == 0;
+    FIOClose(h1);
+    ok = BENCHReport(mixOk,"Mixed reads, writes and seeks") && ok;
+
+    int chunks = 0;                                                             // Save in 512 byte writes
+    start = BENCHTime();
+    FIOCreateFile(name2);h2 = FIOOpen(name2);
+    for (int pos = 0;pos < length;pos += 512) chunks += FIOWrite(h2,text+pos,min(512,length-pos)) == FIO_OK;
+    FIOClose(h2);
+    double chunked = BENCHTime()-start;
+    start = BENCHTime();                                                        // Save it as two parts
+    bool wholeOk = FIOSaveFile2(name,text,length/3,text+length/3,length-length/3) == FIO_OK;
+    double whole = BENCHTime()-start;
+    printf("Save %d bytes, %.2fms in 512 byte writes, %.2fms with FIOSaveFile2 (%.1fx)\n",length,
+                        chunked*1000,whole*1000,chunked/whole);
+    start = BENCHTime();                                                        // Load in 512 byte reads
+    h2 = FIOOpen(name2);
+    int loaded = 0,n;
+    while (n = FIORead(h2,compare+loaded,512),n > 0) loaded += n;
+    FIOClose(h2);
+    chunked = BENCHTime()-start;
+    start = BENCHTime();
+    int wholeSize = FIOLoadFile(name,compare+sizeof(text),sizeof(text));
+    whole = BENCHTime()-start;
+    wholeOk = wholeOk && chunks == (length+511)/512 && loaded == length && wholeSize == length &&
+                    memcmp(compare,text,length) == 0 && memcmp(compare+sizeof(text),text,length) == 0 &&
+                    FIOLoadFile(name,compare,100) == 100 && FIOLoadFile("__nofile",compare,100) == FIO_ERR_NOTFOUND;
+    ok = BENCHReport(wholeOk,"Load %d bytes, %.2fms in 512 byte reads, %.2fms with FIOLoadFile (%.1fx)",length,
+                        chunked*1000,whole*1000,chunked/whole) && ok;
+
+    FIODeleteFile(name2);                                                       // Check the open modes
+    h2 = FIOOpenEx(name2,FIO_OPEN_CREATE_NEW);
+    bool modesOk = h2 >= 0 && FIOWrite(h2,"ABCD",4) == FIO_OK && FIOClose(h2) == FIO_OK;
+    modesOk = modesOk && FIOOpenEx(name2,FIO_OPEN_CREATE_NEW) == FIO_ERR_EXISTS;
+    h2 = FIOOpenEx(name2,FIO_OPEN_APPEND);                                      // Append goes on the end
+    modesOk = modesOk && FIOGetSetPosition(h2,-1) == 4 && FIOWrite(h2,"EF",2) == FIO_OK && FIOClose(h2) == FIO_OK;
+    h2 = FIOOpenEx(name2,FIO_OPEN_READ);                                        // Read only cannot be written
+    modesOk = modesOk && FIORead(h2,data,10) == 6 && memcmp(data,"ABCDEF",6) == 0 &&
+                    FIOWrite(h2,"X",1) == FIO_ERR_READONLY && FIOClose(h2) == FIO_OK;
+    h2 = FIOOpenEx(name2,FIO_OPEN_TRUNCATE);                                    // Truncate empties it
+    modesOk = modesOk && FIORead(h2,data,10) == 0 && FIOClose(h2) == FIO_OK &&
+                    FIOOpenEx("__nofile",FIO_OPEN_READ) == FIO_ERR_NOTFOUND;
+    ok = BENCHReport(modesOk,"Open modes") && ok;
+
+    h2 = FIOOpenEx(name2,FIO_OPEN_READWRITE);                                   // File size as it is written
+    bool sizeOk = FIOFileSize(h2) == 0 && FIOWrite(h2,"0123456789",10) == FIO_OK && FIOFileSize(h2) == 10;
+    sizeOk = sizeOk && FIOGetSetPosition(h2,4) == 10 && FIOFileSize(h2) == 10 && FIOWrite(h2,"ab",2) == FIO_OK;
+    FIOSetBuffer(h2,buffer,64);                                                 // Buffered, past the end
+    sizeOk = sizeOk && FIOFileSize(h2) == 10 && FIOGetSetPosition(h2,8) == 6 && FIOWrite(h2,"ABCDEF",6) == FIO_OK &&
+                    FIOFileSize(h2) == 14 && FIOGetSetPosition(h2,0) == 14 && FIOFileSize(h2) == 14;
+    FIOClose(h2);
+    h2 = FIOOpenEx(name2,FIO_OPEN_READ);
+    sizeOk = sizeOk && FIOFileSize(h2) == 14 && FIORead(h2,data,20) == 14 && memcmp(data,"0123ab67ABCDEF",14) == 0;
+    FIOClose(h2);
+    sizeOk = sizeOk && FIOFileSize(h2) == FIO_ERR_HANDLE;
+    ok = BENCHReport(sizeOk,"File size kept while writing") && ok;
+
+    FIODeleteFile(name);FIODeleteFile(name2);
+    return ok ? 0 : 1;
+}
+
+#define BENCH_DIRECTORY     "/__dirbench"
+#define BENCH_DIR_FILES     (500)
+
+/**
+ * @brief      List the test directory, as the directory command did, getting
+ *             information on each name, or with FIOReadDirectoryEx()
+ *
+ * @param[in]  fused  Use FIOReadDirectoryEx()
+ * @param      total  Total of the file lengths
+ *
+ * @return     Number of files, or -1 on error
+ */
+static int _BENCHListDirectory(bool fused,int *total) {
+    FIOInfo info;
+    char path[64];
+    int count = 0;
+    *total = 0;
+    int h = FIOOpenDirectory(BENCH_DIRECTORY);
+    if (h < 0) return -1;
+    while (true) {
+        if (fused) {
+            if (FIOReadDirectoryEx(h,&info) != 0) break;
+        } else {
+            if (FIOReadDirectory(h,info.name) != 0) break;
+            sprintf(path,"%s/%s",BENCH_DIRECTORY,info.name);
+            if (FIOFileInformation(path,&info) != 0) count = -BENCH_DIR_FILES*2;
+        }
+        if (!info.isDirectory) {
+            count++;*total += info.length;
+        }
+    }
+    FIOCloseDirectory(h);
+    return max(count,-1);
+}
+
+/**
+ * @brief      Time listing a directory with and without the size and type
+ *             coming from the directory read, and check several directories
+ *             can be read at once.
+ *
+ * @return     0 if all ok, 1 otherwise.
+ */
+int BENCHDirectory(void) {
+    char name[64];
+    int expected = 0;
+    bool ok = true;
+    FIOCreateDirectory(BENCH_DIRECTORY);
+    for (int i = 0;i < BENCH_DIR_FILES;i++) {                                   // Files of 0-49 bytes.
+        sprintf(name,"%s/file%03d.dat",BENCH_DIRECTORY,i);
+        FIOCreateFile(name);
+        int h = FIOOpen(name);
+        FIOWrite(h,name,i % 50);FIOClose(h);
+        expected += i % 50;
+    }
+    for (int fused = 0;fused < 2;fused++) {
+        int total = 0,count = 0;
+        double start = BENCHTime();
+        for (int i = 0;i < 10;i++) count = _BENCHListDirectory(fused,&total);
+        double time = (BENCHTime()-start)/10;
+        bool listOk = count == BENCH_DIR_FILES && total == expected;
+        ok = BENCHReport(listOk,"List %d files %s, %.2fms",count,fused ? "with FIOReadDirectoryEx":"with FIOFileInformation",
+                                                                time*1000) && ok;
+    }
+
+    int h[FIO_MAX_DIRECTORIES],entries[2] = { 0,0 };                             // Read two at once
+    FIOInfo info;
+    h[0] = FIOOpenDirectory(BENCH_DIRECTORY);h[1] = FIOOpenDirectory(BENCH_DIRECTORY);
+    bool more = true;
+    while (more) {
+        more = false;
+        for (int i = 0;i < 2;i++) {
+            if (FIOReadDirectoryEx(h[i],&info) == 0) {
+                entries[i]++;more = true;
+            }
+        }
+    }
+    for (int i = 2;i < FIO_MAX_DIRECTORIES;i++) h[i] = FIOOpenDirectory("/");
+    bool concurrentOk = h[0] >= 0 && h[1] >= 0 && entries[0] == entries[1] && entries[0] >= BENCH_DIR_FILES &&
+                            h[FIO_MAX_DIRECTORIES-1] >= 0 && FIOOpenDirectory("/") == FIO_ERR_MAXFILES;
+    for (int i = 0;i < FIO_MAX_DIRECTORIES;i++) FIOCloseDirectory(h[i]);
+    concurrentOk = concurrentOk && FIOReadDirectoryEx(h[0],&info) == FIO_ERR_HANDLE;
+    ok = BENCHReport(concurrentOk,"%d directories read at once",FIO_MAX_DIRECTORIES) && ok;
+
+    #ifndef ARTSIM_FATFS
+    int total = 0;                                                              // A broken link on the host is skipped
+    bool linkOk = symlink("missing","storage" BENCH_DIRECTORY "/broken") == 0;
+    linkOk = linkOk && _BENCHListDirectory(true,&total) == BENCH_DIR_FILES && total == expected;
+    unlink("storage" BENCH_DIRECTORY "/broken");
+    ok = BENCHReport(linkOk,"Broken link skipped when listing") && ok;
+    #endif
+
+    for (int i = 0;i < BENCH_DIR_FILES;i++) {
+        sprintf(name,"%s/file%03d.dat",BENCH_DIRECTORY,i);
+        FIODeleteFile(name);
+    }
+    FIODeleteDirectory(BENCH_DIRECTORY);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief      Change directory and check where it ends up
+ *
+ * @param      change    Directory to change to
+ * @param[in]  error     Error expected
+ * @param      expected  Current directory expected afterwards
+ *
+ * @return     true if as expected
+ */
+static bool _BENCHChangeDirectory(char *change,int error,char *expected) {
+    int e = FIOChangeCWD(change);
+    bool ok = (e == error) && strcmp(FIOGetCWD(),expected) == 0;
+    if (!ok) printf("    cd %s gave %d %s, expected %d %s\n",change,e,FIOGetCWD(),error,expected);
+    return ok;
+}
+
+/**
+ * @brief      Time opening a file repeatedly
+ *
+ * @param      name   The name to open
+ * @param[in]  count  Number of times
+ *
+ * @return     Time for each open and close in seconds, -1 if it failed
+ */
+static double _BENCHTimeOpen(char *name,int count) {
+    double start = BENCHTime();
+    for (int i = 0;i < count;i++) {
+        int h = FIOOpenEx(name,FIO_OPEN_READ);
+        if (h < 0) return -1;
+        FIOClose(h);
+    }
+    return (BENCHTime()-start)/count;
+}
+
+/**
+ * @brief      Check changing directory and relative names, and that a name
+ *             too long to add to the current directory is an error. Time
+ *             opening a file 4 directories down by relative and absolute
+ *             name. This only differs when the file system keeps its own
+ *             directory (FATFS=1, f_chdir()), on the host both open the same
+ *             absolute path.
+ *
+ * @return     0 if all ok, 1 otherwise.
+ */
+int BENCHWorkingDirectory(void) {
+    char *deepFile = "/__cwd/one/two/three/four/data.txt";
+    FIOCreateDirectory("/__cwd");FIOCreateDirectory("/__cwd/one");FIOCreateDirectory("/__cwd/one/two");
+    FIOCreateDirectory("/__cwd/one/two/three");FIOCreateDirectory("/__cwd/one/two/three/four");
+    FIOSaveFile(deepFile,"data",4);
+
+    bool ok = _BENCHChangeDirectory("/",0,"/") && _BENCHChangeDirectory("..",0,"/") &&
+                _BENCHChangeDirectory("__cwd",0,"/__cwd") &&
+                _BENCHChangeDirectory("one/./two//three/",0,"/__cwd/one/two/three") &&
+                _BENCHChangeDirectory("..",0,"/__cwd/one/two") &&
+                _BENCHChangeDirectory("../../one/two/three/four",0,"/__cwd/one/two/three/four") &&
+                _BENCHChangeDirectory("missing",FIO_ERR_NOTFOUND,"/__cwd/one/two/three/four") &&
+                _BENCHChangeDirectory("data.txt",FIO_ERR_NOTDIR,"/__cwd/one/two/three/four") &&
+                _BENCHChangeDirectory("",0,"/__cwd/one/two/three/four");
+    char data[8];
+    ok = ok && FIOLoadFile("data.txt",data,sizeof(data)) == 4 && FIOLoadFile("../four/./data.txt",data,sizeof(data)) == 4;
+    BENCHReport(ok,"Changing directory and relative names");
+
+    char longName[250];                                                         // Fits, but not after the directory
+    memset(longName,'x',sizeof(longName)-1);longName[sizeof(longName)-1] = '\0';
+    bool longOk = FIOOpenEx(longName,FIO_OPEN_READ) == FIO_ERR_COMMAND &&
+                    FIOFileInformation(longName,NULL) == FIO_ERR_COMMAND && FIOCreateFile(longName) == FIO_ERR_COMMAND;
+    ok = BENCHReport(longOk,"Name too long for the directory is an error") && ok;
+
+    char *relativeName = "data.txt";
+    bool isNative = FIOMapFileName(relativeName) == relativeName;               // Passed on as it is, not joined.
+    double relative = _BENCHTimeOpen(relativeName,2000);
+    double absolute = _BENCHTimeOpen(deepFile,2000);
+    ok = BENCHReport(relative >= 0 && absolute >= 0,"Open and close 4 directories down, %.2fus relative (%s), %.2fus absolute",
+                relative*1e6,isNative ? "from the directory" : "joined to the path",absolute*1e6) && ok;
+
+    FIOChangeCWD("/");
+    FIODeleteFile(deepFile);
+    FIODeleteDirectory("/__cwd/one/two/three/four");FIODeleteDirectory("/__cwd/one/two/three");
+    FIODeleteDirectory("/__cwd/one/two");FIODeleteDirectory("/__cwd/one");FIODeleteDirectory("/__cwd");
+    return ok ? 0 : 1;
+}
+
+#define BENCH_ASYNC_SIZE    (1024*1024)
+
+static int asyncCallbacks,asyncBytes;                                           // Callbacks made and bytes reported
+
+/**
+ * @brief      Asynchronous request callback
+ *
+ * @param[in]  request  The request number
+ * @param[in]  result   Bytes transferred or error
+ * @param      context  Context, the expected size
+ */
+static void _BENCHAsyncCallback(int request,int result,void *context) {
+    asyncCallbacks++;
+    if (result == *(int *)context) asyncBytes += result;
+}
+
+/**
+ * @brief      Read a file with blocking and asynchronous reads, counting how
+ *             often the program could have run while waiting, and check
+ *             writes with callbacks, end of file, errors and a full queue.
+ *
+ * @return     0 if all ok, 1 otherwise.
+ */
+int BENCHAsync(void) {
+    static uint8_t data[BENCH_ASYNC_SIZE],check[BENCH_ASYNC_SIZE*2];
+    char *name = "__async.dat";
+    bool ok = true;
+    for (int i = 0;i < BENCH_ASYNC_SIZE;i++) data[i] = (i * 7) ^ (i >> 10);
+    FIOSaveFile(name,data,BENCH_ASYNC_SIZE);
+
+    double start = BENCHTime();                                                 // Blocking, in chunks.
+    int h = FIOOpenEx(name,FIO_OPEN_READ);
+    for (int pos = 0;pos < BENCH_ASYNC_SIZE;pos += FIO_ASYNC_CHUNK) FIORead(h,check+pos,FIO_ASYNC_CHUNK);
+    FIOClose(h);
+    double blocking = BENCHTime()-start;
+
+    memset(check,0,BENCH_ASYNC_SIZE);                                           // Asynchronous, past the end
+    int loops = 0,result;
+    start = BENCHTime();
+    h = FIOOpenEx(name,FIO_OPEN_READ);
+    int request = FIOReadAsync(h,check,sizeof(check),NULL,NULL);
+    while (!FIOAsyncIsComplete(request,&result)) {                              // The program carries on
+        loops++;
+        FIOAsyncTick();
+    }
+    FIOClose(h);
+    double async = BENCHTime()-start;
+    bool readOk = request >= 0 && result == BENCH_ASYNC_SIZE && memcmp(check,data,BENCH_ASYNC_SIZE) == 0;
+    ok = BENCHReport(readOk,"Read %dk, %.2fms blocking, %.2fms asynchronous, program ran %d times while waiting",
+                BENCH_ASYNC_SIZE/1024,blocking*1000,async*1000,loops) && ok;
+
+    int part = BENCH_ASYNC_SIZE/4;                                              // Write in 4 parts with callbacks
+    h = FIOOpenEx(name,FIO_OPEN_TRUNCATE);
+    for (int i = 0;i < BENCH_ASYNC_SIZE;i++) data[i] = ~data[i];
+    asyncCallbacks = asyncBytes = 0;
+    for (int i = 0;i < 4;i++) FIOWriteAsync(h,data+i*part,part,_BENCHAsyncCallback,&part);
+    while (asyncCallbacks < 4 || FIOAsyncPending() != 0) FIOAsyncTick();
+    FIOClose(h);
+    bool writeOk = asyncBytes == BENCH_ASYNC_SIZE && FIOLoadFile(name,check,sizeof(check)) == BENCH_ASYNC_SIZE &&
+                                memcmp(check,data,BENCH_ASYNC_SIZE) == 0;
+    ok = BENCHReport(writeOk,"Write %dk in 4 requests with callbacks",BENCH_ASYNC_SIZE/1024) && ok;
+
+    h = FIOOpenEx(name,FIO_OPEN_READ);                                          // Fill the queue
+    int requests[FIO_ASYNC_REQUESTS];
+    for (int i = 0;i < FIO_ASYNC_REQUESTS;i++) requests[i] = FIOReadAsync(h,check,16,NULL,NULL);
+    bool queueOk = FIOReadAsync(h,check,16,NULL,NULL) == FIO_ERR_BUSY;
+    for (int i = 0;i < FIO_ASYNC_REQUESTS;i++) queueOk = queueOk && FIOAsyncWait(requests[i]) == 16;
+    request = FIOReadAsync(h,check,16,NULL,NULL);                               // Reuses a slot, not the old number
+    queueOk = queueOk && request != requests[0] && FIOAsyncIsComplete(requests[0],&result) &&
+                            result == FIO_ERR_HANDLE && FIOAsyncWait(request) == 16;
+    FIOClose(h);
+    queueOk = queueOk && FIOAsyncWait(FIOReadAsync(FIO_MAX_HANDLES-1,check,16,NULL,NULL)) == FIO_ERR_HANDLE &&
+                            FIOAsyncPending() == 0;
+    ok = BENCHReport(queueOk,"Full queue and errors") && ok;
+
+    FIODeleteFile(name);
+    return ok ? 0 : 1;
+}
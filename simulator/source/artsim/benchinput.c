@@ -0,0 +1,210 @@
+/**
+ * @file       benchinput.c
+ *
+ * @brief      Input benchmarks and checks, the keyboard and event queues and
+ *             the HID report decoder.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+#include "bench.h"
+
+/**
+ * @brief      Keyboard queue checks, order through the ring, bulk insertion,
+ *             overflow counting and dequeue time.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHKeyboard(void) {
+    static char text[1000];
+    bool ok = true;
+    KBDReceiveEvent(0,0xFF,0);                                                  // Reset, empties the queue.
+    int size = KBDQueueFree();
+    for (int i = 0;i < (int)sizeof(text);i++) text[i] = 32+i % 95;
+    int sent = 0,received = 0;
+    bool orderOk = true;
+    while (received < (int)sizeof(text)) {                                      // Paste it, reading a few at a time.
+        sent += KBDInsertQueueBulk(text+sent,sizeof(text)-sent);
+        for (int i = 0;i < 7 && KBDIsKeyAvailable();i++) {
+            orderOk = orderOk && KBDGetKey() == text[received++];
+        }
+    }
+    ok = BENCHReport(orderOk,"Queue size %d, pasted %d keys in order",size,received) && ok;
+    ok = ok && !KBDIsKeyAvailable();
+
+    uint32_t overflows = KBDGetOverflowCount();                                 // Overfill it
+    for (int i = 0;i < size+10;i++) KBDInsertQueue('A');
+    bool overflowOk = KBDGetOverflowCount()-overflows == 10 && KBDQueueFree() == 0;
+    ok = BENCHReport(overflowOk,"Overflow count %u",KBDGetOverflowCount()-overflows) && ok;
+
+    int count = 0;                                                              // Time to dequeue a full queue
+    double start = BENCHTime();
+    for (int n = 0;n < 10000;n++) {
+        while (KBDGetKey() != 0) count++;
+        KBDInsertQueueBulk(text,size);
+    }
+    double elapsed = BENCHTime()-start;
+    printf("Dequeue and refill %.1fns per key\n",elapsed*1e9/count);
+    KBDReceiveEvent(0,0xFF,0);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief      Event queue checks, order, mouse move merging, controller
+ *             change detection, overflow counting and cost per event.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHEvents(void) {
+    static EVTEvent events[EVT_QUEUE_SIZE];
+    static const int expected[] = { EVT_KEY_DOWN,EVT_MOUSE_MOVE,EVT_MOUSE_BUTTON,EVT_MOUSE_MOVE,
+                                    EVT_MOUSE_WHEEL,EVT_KEY_UP,EVT_CONTROLLER };
+    int count = sizeof(expected)/sizeof(int);
+    CTLState pad = { .dx = 1,.dy = 0,.a = true };
+    bool ok = true;
+    KBDReceiveEvent(0,0xFF,0);
+    EVTFlush();
+    KBDReceiveEvent(1,KEY_A,KEY_MOD_LSHIFT);                                    // A sequence of events.
+    for (int i = 1;i <= 50;i++) MSESetPosition(i,i*2);                          // Merged into one.
+    MSEUpdateButtonState(1);
+    MSESetPosition(10,10);MSESetPosition(11,11);                                // New move after the button.
+    MSEUpdateScrollWheel(-1);
+    KBDReceiveEvent(0,KEY_A,0);
+    EVTControllerState(0,&pad);EVTControllerState(0,&pad);                      // Only the change is queued.
+    int n = EVTReadEvents(events,EVT_QUEUE_SIZE);
+    bool orderOk = (n == count);
+    for (int i = 0;i < n && orderOk;i++) {
+        orderOk = events[i].type == expected[i] && (i == 0 || events[i].time >= events[i-1].time);
+    }
+    orderOk = orderOk && events[0].code == KEY_A && events[0].device == KEY_MOD_LSHIFT &&
+                events[1].x == 50 && events[1].y == 100 && events[3].x == 11 && events[4].y == -1 &&
+                events[6].code == EVT_BUTTON_A && events[6].x == 1 && EVTPending() == 0;
+    ok = BENCHReport(orderOk,"Read %d events, order and contents",n) && ok;
+
+    uint32_t overflows = EVTGetOverflowCount();                                 // Overfill it
+    for (int i = 0;i < EVT_QUEUE_SIZE+10;i++) EVTRecord(EVT_KEY_DOWN,0,KEY_A,0,0);
+    bool overflowOk = EVTGetOverflowCount()-overflows == 10 && EVTPending() == EVT_QUEUE_SIZE;
+    ok = BENCHReport(overflowOk,"Overflow count %u",EVTGetOverflowCount()-overflows) && ok;
+
+    int total = 0;                                                              // Cost to record and read
+    double start = BENCHTime();
+    for (int r = 0;r < 10000;r++) {
+        total += EVTReadEvents(events,EVT_QUEUE_SIZE);
+        for (int i = 0;i < EVT_QUEUE_SIZE;i++) EVTRecord(EVT_KEY_UP,0,i,0,0);
+    }
+    double elapsed = BENCHTime()-start;
+    printf("Record and read %.1fns per event\n",elapsed*1e9/total);
+    EVTFlush();
+    MSESetPosition(0,0);MSEUpdateButtonState(0);
+    KBDReceiveEvent(0,0xFF,0);
+    EVTFlush();
+    return ok ? 0 : 1;
+}
+
+static char hidEvents[256];                                                     // Events from the report decoder
+static int hidCount;
+
+/**
+ * @brief      Record a key event from the HID report decoder
+ *
+ * @param[in]  isDown     true if pressed
+ * @param[in]  keyCode    The key code
+ * @param[in]  modifiers  The modifiers
+ */
+static void _BENCHHIDEvent(uint8_t isDown,uint8_t keyCode,uint8_t modifiers) {
+    int n = strlen(hidEvents);
+    if (n < (int)sizeof(hidEvents)-8) sprintf(hidEvents+n,"%s%c%02x",n == 0 ? "":" ",isDown ? '+':'-',keyCode);
+}
+
+/**
+ * @brief      Count key events from the HID report decoder, for timing
+ *
+ * @param[in]  isDown     true if pressed
+ * @param[in]  keyCode    The key code
+ * @param[in]  modifiers  The modifiers
+ */
+static void _BENCHHIDCount(uint8_t isDown,uint8_t keyCode,uint8_t modifiers) {
+    hidCount++;
+}
+
+/**
+ * @brief      Send a sequence of HID keyboard reports to the decoder and check
+ *             the events match.
+ *
+ * @param      name      Name of the sequence
+ * @param      reports   Reports, one after another
+ * @param[in]  count     Number of reports
+ * @param[in]  size      Size of each report
+ * @param      expected  Expected events
+ *
+ * @return     true if they match
+ */
+static bool _BENCHHIDSequence(char *name,const uint8_t *reports,int count,int size,char *expected) {
+    hidEvents[0] = '\0';
+    for (int i = 0;i < count;i++) HIDKeyboardReport(reports+i*size,size,_BENCHHIDEvent);
+    return BENCHReport(strcmp(hidEvents,expected) == 0,"%-10s %-40s",name,hidEvents);
+}
+
+/**
+ * @brief      HID keyboard report checks, recorded boot and NKRO report
+ *             sequences, and time per report.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHHID(void) {
+    static const uint8_t typing[][8] = {                                        // A, A+B, B, rollover, nothing
+        { 0,0,4 },{ 0,0,4,5 },{ 0,0,5 },{ 0,0,1,1,1,1,1,1 },{ 0 }
+    };
+    static const uint8_t keypad[][8] = { { 0,0,0x59 },{ 0,0,0x59,0x62 },{ 0 } };    // KP1, KP1+KP0
+    static const uint8_t reorder[][8] = { { 0,0,4,5,6 },{ 0,0,6,4,5 },{ 0,0,6 },{ 0 } };
+    static uint8_t nkro[4][17];                                                 // Modifiers, 128 key bitmap
+    static const uint8_t idReports[][9] = { { 1,0,0,4 },{ 2,0,0,9 },{ 1,0,0,4,5 },{ 1 } };  // Report 2 is not keys
+    static const uint8_t bootDesc[] = {                                         // Boot layout: modifiers, reserved, 6 keys
+        0x05,0x01,0x09,0x06,0xA1,0x01,0x05,0x07,0x19,0xE0,0x29,0xE7,0x15,0x00,0x25,0x01,0x75,0x01,0x95,0x08,0x81,0x02,
+        0x95,0x01,0x75,0x08,0x81,0x01,0x95,0x05,0x75,0x01,0x05,0x08,0x19,0x01,0x29,0x05,0x91,0x02,0x95,0x01,0x75,0x03,
+        0x91,0x01,0x95,0x06,0x75,0x08,0x15,0x00,0x25,0x65,0x05,0x07,0x19,0x00,0x29,0x65,0x81,0x00,0xC0 };
+    static const uint8_t bootIdDesc[] = {                                       // The same with report ID 1, and a report 2
+        0x05,0x01,0x09,0x06,0xA1,0x01,0x85,0x01,0x05,0x07,0x19,0xE0,0x29,0xE7,0x15,0x00,0x25,0x01,0x75,0x01,0x95,0x08,
+        0x81,0x02,0x95,0x01,0x75,0x08,0x81,0x01,0x95,0x06,0x75,0x08,0x15,0x00,0x25,0x65,0x05,0x07,0x19,0x00,0x29,0x65,
+        0x81,0x00,0xC0,0x05,0x0C,0x09,0x01,0xA1,0x01,0x85,0x02,0x75,0x10,0x95,0x01,0x81,0x00,0xC0 };
+    static const uint8_t nkroDesc[] = {                                         // Modifiers, then a bitmap of keys 0-127
+        0x05,0x01,0x09,0x06,0xA1,0x01,0x05,0x07,0x19,0xE0,0x29,0xE7,0x15,0x00,0x25,0x01,0x75,0x01,0x95,0x08,0x81,0x02,
+        0x05,0x07,0x19,0x00,0x29,0x7F,0x95,0x80,0x75,0x01,0x81,0x02,0xC0 };
+    bool ok = true;
+    HIDKeyboardReset();
+    ok = _BENCHHIDSequence("boot",typing[0],5,8,"+04 +05 -04 -05") && ok;
+    ok = _BENCHHIDSequence("keypad",keypad[0],3,8,"+1e +27 -1e -27") && ok;
+    ok = _BENCHHIDSequence("order",reorder[0],4,8,"+04 +05 +06 -04 -05 -06") && ok;
+    bool descOk = HIDKeyboardSetDescriptor(nkroDesc,sizeof(nkroDesc),_BENCHHIDEvent);
+    for (int k = 4;k < 14;k++) nkro[0][1+k/8] |= 1 << (k & 7);                  // 10 keys at once
+    memcpy(nkro[1],nkro[0],17);nkro[1][1] &= ~0x30;                             // Release 4 and 5
+    nkro[2][1] = 0x10;                                                          // Just 4, then nothing.
+    ok = _BENCHHIDSequence("nkro",nkro[0],4,17,"+04 +05 +06 +07 +08 +09 +0a +0b +0c +0d -04 -05 +04 -06 -07 -08 -09 -0a -0b -0c -0d -04") && ok;
+    HIDKeyboardReport(nkro[2],17,_BENCHHIDEvent);
+    hidEvents[0] = '\0';                                                        // A new keyboard releases everything
+    descOk = HIDKeyboardSetDescriptor(bootDesc,sizeof(bootDesc),_BENCHHIDEvent) && strcmp(hidEvents,"-04") == 0 && descOk;
+    ok = _BENCHHIDSequence("switch",typing[1],1,8,"+04 +05") && ok;
+    descOk = HIDKeyboardSetDescriptor(bootIdDesc,sizeof(bootIdDesc),_BENCHHIDEvent) && descOk;
+    ok = _BENCHHIDSequence("reportid",idReports[0],4,9,"+04 +05 -04 -05") && ok;
+    descOk = !HIDKeyboardSetDescriptor(NULL,0,_BENCHHIDEvent) && descOk;        // Back to the boot protocol
+    ok = BENCHReport(descOk,"%-10s %-40s","descriptor","") && ok;
+    uint8_t reboot[8] = { REBOOT_KEYS,0,0x4C };
+    bool rebootOk = HIDKeyboardReport(reboot,8,_BENCHHIDEvent) && !HIDKeyboardReport(typing[4],8,_BENCHHIDEvent);
+    ok = BENCHReport(rebootOk,"%-10s %-40s","reboot","") && ok;
+
+    double start = BENCHTime();                                                 // Time per report
+    hidCount = 0;
+    for (int n = 0;n < 1000000;n++) HIDKeyboardReport(typing[n & 1],8,_BENCHHIDCount);
+    printf("Boot report %.1fns, %d events\n",(BENCHTime()-start)*1e9/1000000,hidCount);
+    HIDKeyboardSetDescriptor(nkroDesc,sizeof(nkroDesc),_BENCHHIDCount);
+    start = BENCHTime();
+    hidCount = 0;
+    for (int n = 0;n < 1000000;n++) HIDKeyboardReport(nkro[n & 1],17,_BENCHHIDCount);
+    printf("NKRO report %.1fns, %d events\n",(BENCHTime()-start)*1e9/1000000,hidCount);
+    HIDKeyboardReset();
+    return ok ? 0 : 1;
+}
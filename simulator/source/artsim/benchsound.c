@@ -0,0 +1,573 @@
+/**
+ * @file       benchsound.c
+ *
+ * @brief      Sound benchmarks and checks, and music rendering to WAV files.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+#include "bench.h"
+
+#define BENCH_FIRMWARE_RATE (252000*1024/32/255)                                // PWM sample rate on the hardware (Hz)
+
+/**
+ * @brief      Set up a channel for the benchmarks
+ *
+ * @param[in]  channel    Channel number
+ * @param[in]  type       Sound type
+ * @param[in]  frequency  Frequency in Hz
+ * @param[in]  volume     Volume 0-127
+ */
+static void _BENCHSetChannel(int channel,int type,int frequency,int volume) {
+    SNDCHANNEL c;
+    c.type = type;c.frequency = frequency;c.volume = volume;
+    SNDUpdate(channel,&c);
+}
+
+//
+//      The generator before the phase accumulators, kept to compare the cost of the two.
+//
+static struct _BenchOldChannel {
+    int limit,wrapper,state,soundType,volume;
+} oldAudio[4];
+
+/**
+ * @brief      Set up a channel of the old generator, as its SNDUpdate did
+ *
+ * @param[in]  channel    Channel number
+ * @param[in]  type       Sound type
+ * @param[in]  frequency  Frequency in Hz
+ * @param[in]  volume     Volume 0-127
+ */
+static void _BENCHSetOldChannel(int channel,int type,int frequency,int volume) {
+    struct _BenchOldChannel *cs = &oldAudio[channel];
+    cs->limit = BENCH_FIRMWARE_RATE/frequency/2;cs->wrapper = cs->state = 0;
+    cs->soundType = type;cs->volume = volume;
+}
+
+/**
+ * @brief      Render a block with the old generator, a level only on the
+ *             sample where a channel's counter wraps.
+ *
+ * @param      out   Buffer for samples -128 .. 127
+ * @param[in]  n     Number of samples, at most 64
+ */
+static void _BENCHOldRenderBlock(int8_t *out,int n) {
+    int16_t mix[64];
+    int channelsActive = 0;
+    memset(mix,0,n*sizeof(int16_t));
+    for (int c = 0;c < 4;c++) {
+        struct _BenchOldChannel *cs = &oldAudio[c];
+        if (cs->volume == 0) continue;
+        channelsActive++;
+        int wrapper = cs->wrapper,limit = cs->limit,state = cs->state,volume = cs->volume;
+        for (int i = 0;i < n;i++) {
+            if (wrapper-- == 0) {
+                wrapper = limit;
+                state ^= 0xFF;
+                if (cs->soundType == SNDTYPE_NOISE) {
+                    mix[i] += (rand() & 0xFF)-0x80;
+                } else {
+                    mix[i] += state ? volume : -volume;
+                }
+            }
+        }
+        cs->wrapper = wrapper;cs->state = state;
+    }
+    int scale = (channelsActive > 1) ? 3 : 4;
+    for (int i = 0;i < n;i++) {
+        int level = mix[i] * scale / 4;
+        if (level < -127) level = -127;
+        if (level > 127) level = 127;
+        out[i] = level;
+    }
+}
+
+/**
+ * @brief      Sound synthesis benchmark, all four channels active. The
+ *             block rendering is compared with the old generator on the
+ *             same channels. Both are timed on the host, the cost on the
+ *             M0+ is not measured.
+ *
+ * @return     Exit status
+ */
+int BENCHSound(void) {
+    static int8_t block[256];
+    int seconds = 20;                                                           // Audio seconds to render.
+    int total = BENCH_FIRMWARE_RATE*seconds;
+    _BENCHSetChannel(0,SNDTYPE_SQUARE,440,64);
+    _BENCHSetChannel(1,SNDTYPE_SQUARE,554,64);
+    _BENCHSetChannel(2,SNDTYPE_SQUARE,659,64);
+    _BENCHSetChannel(3,SNDTYPE_NOISE,2000,32);
+
+    double start = BENCHTime();                                                 // Sample at a time.
+    for (int i = 0;i < total;i++) block[i & 0xFF] = SNDGetChannelSample(0);
+    double single = BENCHTime()-start;
+
+    start = BENCHTime();                                                        // Blocks of samples.
+    for (int i = 0;i < total;i += sizeof(block)) SNDRenderBlock(block,sizeof(block));
+    double blocks = BENCHTime()-start;
+
+    _BENCHSetOldChannel(0,SNDTYPE_SQUARE,440,64);                               // The old generator, same channels.
+    _BENCHSetOldChannel(1,SNDTYPE_SQUARE,554,64);
+    _BENCHSetOldChannel(2,SNDTYPE_SQUARE,659,64);
+    _BENCHSetOldChannel(3,SNDTYPE_NOISE,2000,32);
+    start = BENCHTime();
+    for (int i = 0;i < total;i += 64) _BENCHOldRenderBlock(block,64);
+    double old = BENCHTime()-start;
+
+    printf("Rendered %d samples (%ds at the hardware rate of %dHz)\n",total,seconds,BENCH_FIRMWARE_RATE);
+    printf("Per sample : %12.0f samples/s, %.3f%% of a host core\n",total/single,100.0*single/seconds);
+    printf("Blocks     : %12.0f samples/s, %.3f%% of a host core\n",total/blocks,100.0*blocks/seconds);
+    printf("Old blocks : %12.0f samples/s, %.3f%% of a host core\n",total/old,100.0*old/seconds);
+    printf("Blocks take %.2f times as long as the old generator on the host (M0+ cycles not measured)\n",blocks/old);
+    SNDMuteAllChannels();
+    return 0;
+}
+
+/**
+ * @brief      Check a square wave's frequency, amplitude and duty cycle over
+ *             one second of output.
+ *
+ * @param[in]  frequency  Frequency in Hz
+ * @param[in]  volume     Volume 0-127
+ *
+ * @return     true if correct
+ */
+static bool _BENCHCheckTone(int frequency,int volume) {
+    int rate = SNDGetSampleFrequency();
+    int8_t sample,last = 0;
+    int rising = 0,high = 0,minLevel = 0,maxLevel = 0;
+    _BENCHSetChannel(0,SNDTYPE_SQUARE,frequency,volume);
+    for (int i = 0;i < rate;i++) {
+        SNDRenderBlock(&sample,1);
+        if (sample > 0 && last <= 0) rising++;
+        if (sample > 0) high++;
+        minLevel = min(minLevel,sample);maxLevel = max(maxLevel,sample);
+        last = sample;
+    }
+    int duty = high * 1000 / rate;                                              // Duty cycle in 0.1% units
+    bool ok = abs(rising-frequency) <= 1 && maxLevel == volume && minLevel == -volume && abs(duty-500) <= 5;
+    return BENCHReport(ok,"Square %5dHz vol %3d : measured %5dHz, levels %d..%d, duty %d.%d%%",
+                                    frequency,volume,rising,minLevel,maxLevel,duty/10,duty%10);
+}
+
+/**
+ * @brief      Check the noise generator is full amplitude and unbiased
+ *
+ * @return     true if correct
+ */
+static bool _BENCHCheckNoise(void) {
+    int rate = SNDGetSampleFrequency();
+    int8_t sample,last = 0;
+    int changes = 0,total = 0;
+    _BENCHSetChannel(0,SNDTYPE_NOISE,2000,100);
+    for (int i = 0;i < rate;i++) {
+        SNDRenderBlock(&sample,1);
+        if (sample != 100 && sample != -100) {
+            return BENCHReport(false,"Noise level %d out of range",sample);
+        }
+        if (sample != last) changes++;
+        total += sample;last = sample;
+    }
+    int bias = total / rate;
+    bool ok = abs(bias) <= 5 && changes > 1000 && changes < 4000;               // About half of the 4000 new levels change.
+    return BENCHReport(ok,"Noise  2000Hz vol 100 : %d level changes, bias %d",changes,bias);
+}
+
+/**
+ * @brief      Check samples play back unchanged at the output rate, loop,
+ *             and stop at the end, and a wavetable plays at the right pitch.
+ *
+ * @return     true if correct
+ */
+static bool _BENCHCheckSample(void) {
+    static int8_t data[1000],wave[32];
+    int8_t out[2500];
+    int8_t sample;
+    int rate = SNDGetSampleFrequency();
+    bool ok = true;
+    for (int i = 0;i < 1000;i++) data[i] = (i * 37) % 255 - 127;
+    SNDPlaySample(0,data,1000,-1,rate,127);                                     // Once through, at the output rate.
+    SNDRenderBlock(out,1200);
+    for (int i = 0;i < 1200;i++) ok = ok && out[i] == ((i < 1000) ? data[i] : 0);
+    SNDPlaySample(0,data,1000,600,rate,127);                                    // Looped, from 600 to the end.
+    SNDRenderBlock(out,2500);
+    for (int i = 0;i < 2500;i++) ok = ok && out[i] == data[(i < 1000) ? i : 600+(i-1000) % 400];
+    BENCHReport(ok,"Sample playback and looping");
+
+    static int8_t longData[0xFFFF];                                             // Full length at 4x, the end position is
+    memset(longData,64,sizeof(longData));                                       // near 2^32, it must stop rather than wrap.
+    SNDPlaySample(0,longData,sizeof(longData),-1,rate*4,127);
+    int played = 0;
+    for (int i = 0;i < 20000;i++) {
+        SNDRenderBlock(&sample,1);
+        if (sample != 0) played++;
+    }
+    ok = BENCHReport(played == (int)(sizeof(longData)+3)/4,"Full length sample at 4x : %d samples played",played) && ok;
+
+    SNDPlaySample(0,data,1000,-1,rate,127);                                     // Waveform set while a sample plays.
+    SNDRenderBlock(out,100);
+    SNDSetWaveform(0,wave,32);
+    SNDRenderBlock(out,900);
+    bool keepOk = true;
+    for (int i = 0;i < 900;i++) keepOk = keepOk && out[i] == data[100+i];
+    ok = BENCHReport(keepOk,"Sample unchanged by SNDSetWaveform") && ok;
+
+    int rising = 0;                                                             // Sine-ish wavetable.
+    int8_t last = 0;
+    for (int i = 0;i < 32;i++) wave[i] = (i < 16) ? (i < 8 ? i : 16-i)*15 : -((i < 24 ? i-16 : 32-i)*15);
+    SNDSetWaveform(0,wave,32);
+    _BENCHSetChannel(0,SNDTYPE_WAVETABLE,440,127);
+    for (int i = 0;i < rate;i++) {
+        SNDRenderBlock(&sample,1);
+        if (sample > 0 && last <= 0) rising++;
+        last = sample;
+    }
+    ok = BENCHReport(abs(rising-440) <= 1,"Wavetable 440Hz : measured %dHz",rising) && ok;
+    SNDMuteAllChannels();
+    return ok;
+}
+
+/**
+ * @brief      Verify the tone generator's pitch and levels.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHTone(void) {
+    static const int frequencies[] = { 55,110,261,440,1000,1760,4186,0 };
+    bool ok = true;
+    SNDMuteAllChannels();
+    for (int i = 0;frequencies[i] != 0;i++) {
+        ok = _BENCHCheckTone(frequencies[i],127) && ok;
+    }
+    ok = _BENCHCheckTone(440,1) && ok;
+    ok = _BENCHCheckTone(440,64) && ok;
+    ok = _BENCHCheckNoise() && ok;
+    ok = _BENCHCheckSample() && ok;
+    SNDMuteAllChannels();
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief      Sample playback benchmark, four looped sample channels at
+ *             different pitches.
+ *
+ * @return     Exit status
+ */
+int BENCHSamples(void) {
+    static int8_t data[8000],block[256];
+    int seconds = 20;
+    int total = BENCH_FIRMWARE_RATE*seconds;
+    for (int i = 0;i < 8000;i++) data[i] = (int8_t)((i * 7919) >> 3);
+    SNDPlaySample(0,data,8000,0,8000,100);
+    SNDPlaySample(1,data,8000,2000,11025,100);
+    SNDPlaySample(2,data,8000,0,16000,100);
+    SNDPlaySample(3,data,4000,1000,22050,100);
+    double start = BENCHTime();
+    for (int i = 0;i < total;i += sizeof(block)) SNDRenderBlock(block,sizeof(block));
+    double elapsed = BENCHTime()-start;
+    printf("Rendered %d samples, 4 sample channels (%ds at %dHz)\n",total,seconds,BENCH_FIRMWARE_RATE);
+    printf("Blocks     : %12.0f samples/s, %.3f%% of a host core\n",total/elapsed,100.0*elapsed/seconds);
+    SNDMuteAllChannels();
+    return 0;
+}
+
+/**
+ * @brief      Render one 50Hz tick of queued sound offline
+ *
+ * @param      rising  Incremented for each rising edge
+ *
+ * @return     Peak level in the tick
+ */
+static int _BENCHRenderTick(int *rising) {
+    static int8_t last = 0;
+    int8_t block[2048];
+    int count = min((int)sizeof(block),SNDGetSampleFrequency()/50);
+    int peak = 0;
+    SNDTick();
+    SNDRenderBlock(block,count);
+    for (int i = 0;i < count;i++) {
+        if (block[i] > 0 && last <= 0) (*rising)++;
+        peak = max(peak,abs(block[i]));
+        last = block[i];
+    }
+    return peak;
+}
+
+/**
+ * @brief      Render queued notes and envelopes offline, and check they
+ *             start and stop on the right ticks at the right pitch.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHQueue(void) {
+    static const int pitches[3] = { 89,101,53 };                               // 440Hz, 523Hz and middle C
+    static const int expected[3] = { 440,523,262 };
+    bool ok = true;
+    int rising = 0;
+    SNDMuteAllChannels();SNDFlushQueues();
+    for (int i = 0;i < 3;i++) SNDQueueNote(0,SNDTYPE_SQUARE,-15,pitches[i],10,false);
+    ok = BENCHReport(SNDQueueFree(0) == SND_QUEUE_DEPTH-4,"Queue free after 3 notes %d of %d",SNDQueueFree(0),SND_QUEUE_DEPTH-1) && ok;
+    for (int n = 0;n < 3;n++) {                                                 // Each note is 0.5s, 25 ticks.
+        rising = 0;
+        for (int t = 0;t < 25;t++) _BENCHRenderTick(&rising);
+        bool noteOk = abs(rising*2-expected[n]) <= 3;
+        ok = BENCHReport(noteOk,"Note %d pitch %3d : measured %3dHz expected %3dHz",n,pitches[n],rising*2,expected[n]) && ok;
+    }
+    int peak = _BENCHRenderTick(&rising);                                       // Should now be silent.
+    ok = BENCHReport(peak == 0 && !SNDIsChannelPlaying(0),"Silent after 75 ticks") && ok;
+
+    SNDENVELOPE e = { .stepLength = 1,.pitchChange = { 0,0,0 },.pitchSteps = { 0,0,0 },
+                      .attack = 2,.decay = 0,.sustain = 0,.release = -4,.attackLevel = 126,.decayLevel = 126 };
+    SNDDefineEnvelope(1,&e);                                                    // Attack at 4 a tick, release at 8 a tick
+    SNDQueueNote(0,SNDTYPE_SQUARE,1,89,20,false);                               // For 1 second.
+    int levels[100];
+    for (int t = 0;t < 100;t++) levels[t] = _BENCHRenderTick(&rising);
+    int released = 0;
+    while (released < 100 && (released < 50 || levels[released] != 0)) released++;
+    bool envOk = abs(levels[10]-40) <= 4 && levels[40] == 126 && released >= 65 && released <= 68;
+    ok = BENCHReport(envOk,"Envelope levels tick 10 %d, tick 40 %d, silent at tick %d",levels[10],levels[40],released) && ok;
+
+    for (int i = 0;i < 20;i++) SNDQueueNote(1,SNDTYPE_NOISE,-10,i*10,SND_FOREVER,false);
+    bool fullOk = SNDQueueFree(1) == 0 && !SNDQueueNote(1,SNDTYPE_SQUARE,-10,0,1,false);
+    SNDQueueNote(1,SNDTYPE_SQUARE,-10,89,1,true);                               // Flush and replace.
+    fullOk = fullOk && SNDQueueFree(1) == SND_QUEUE_DEPTH-2;
+    ok = BENCHReport(fullOk,"Full queue and flush") && ok;
+    SNDFlushQueues();SNDMuteAllChannels();
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief      Create a test WAV file in storage, 16 bit stereo, with the
+ *             same rising ramp in both channels.
+ *
+ * @param      name    File name
+ * @param[in]  frames  Number of frames
+ * @param[in]  rate    Sample rate
+ *
+ * @return     true if created
+ */
+static bool _BENCHCreateWAV(char *name,int frames,int rate) {
+    static uint8_t data[4096];
+    uint8_t header[44] = { 'R','I','F','F',0,0,0,0,'W','A','V','E','f','m','t',' ',16,0,0,0,1,0,2,0 };
+    #define PUT32(o,v) { header[o] = (v) & 0xFF;header[o+1] = ((v) >> 8) & 0xFF;header[o+2] = ((v) >> 16) & 0xFF;header[o+3] = ((v) >> 24) & 0xFF; }
+    PUT32(4,36+frames*4);PUT32(24,rate);PUT32(28,rate*4);
+    header[32] = 4;header[34] = 16;
+    memcpy(header+36,"data",4);PUT32(40,frames*4);
+    #undef PUT32
+    FIODeleteFile(name);
+    if (FIOCreateFile(name) != 0) return false;
+    int h = FIOOpen(name);
+    if (h < 0) return false;
+    FIOWrite(h,header,44);
+    for (int f = 0;f < frames;f += 1024) {
+        int n = min(1024,frames-f);
+        for (int i = 0;i < n;i++) {
+            data[i*4] = data[i*4+2] = 0;data[i*4+1] = data[i*4+3] = (uint8_t)(f+i);
+        }
+        FIOWrite(h,data,n*4);
+    }
+    FIOClose(h);
+    return true;
+}
+
+/**
+ * @brief      Streaming benchmark. Measures the rate the file system can
+ *             be read at against the rates streaming needs, then streams a
+ *             file offline checking for underruns, timing and seeking.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHStream(void) {
+    static const int rates[] = { 8000,22050,44100,0 };
+    static uint8_t buffer[1024];
+    int8_t block[2048];
+    char *name = "__stream.wav";
+    int seconds = 10,wavRate = 44100;
+    bool ok = true;
+    if (!_BENCHCreateWAV(name,wavRate*seconds,wavRate)) {
+        fprintf(stderr,"Cannot create %s\n",name);
+        return 2;
+    }
+    int h = FIOOpen(name);                                                      // Sustained read rate
+    int total = 0,n;
+    double start = BENCHTime();
+    while ((n = FIORead(h,buffer,sizeof(buffer))) > 0) total += n;
+    double available = total / (BENCHTime()-start);
+    FIOClose(h);
+    printf("File system reads %.0f bytes/s in 1k reads (host, not the USB drive)\n",available);
+    for (int i = 0;rates[i] != 0;i++) {
+        printf("    %5dHz needs %6d bytes/s 8 bit mono, %7d 16 bit stereo, %.2f%% of available\n",
+                            rates[i],rates[i],rates[i]*4,100.0*rates[i]*4/available);
+    }
+
+    int perTick = min((int)sizeof(block),SNDGetSampleFrequency()/50);
+    int maxStep = (wavRate+SNDGetSampleFrequency()-1)/SNDGetSampleFrequency();
+    SNDMuteAllChannels();
+    int err = SNDStreamOpen(name,0,127,false);
+    uint32_t underruns = SNDStreamUnderruns();
+    int ticks = 0;
+    bool rampOk = true;
+    start = BENCHTime();
+    while (SNDStreamIsPlaying() && ticks < 50*seconds*2) {                     // Play it all, a tick at a time
+        SNDStreamTick();
+        SNDRenderBlock(block,perTick);
+        for (int i = 1;i < perTick && ticks < 50*seconds-1;i++) {               // Ramp rises by one a frame, resampled
+            int d = (uint8_t)(block[i]-block[i-1]);
+            rampOk = rampOk && (d <= maxStep || block[i] == -127);             // The mixer clips -128
+        }
+        ticks++;
+    }
+    double elapsed = BENCHTime()-start;
+    bool playOk = err == 0 && abs(ticks-50*seconds) <= 2 && SNDStreamUnderruns() == underruns && rampOk;
+    ok = BENCHReport(playOk,"Streamed %ds in %d ticks, %u underruns, ramp %s, %.2fus per tick",seconds,ticks,
+                    SNDStreamUnderruns()-underruns,rampOk ? "ok":"wrong",elapsed*1e6/max(ticks,1)) && ok;
+
+    err = SNDStreamOpen(name,0,127,false);                                      // Seek to half way
+    if (err == 0) err = SNDStreamSeek(wavRate*seconds/2);
+    for (ticks = 0;SNDStreamIsPlaying() && ticks < 50*seconds;ticks++) {
+        SNDStreamTick();SNDRenderBlock(block,perTick);
+    }
+    bool seekOk = err == 0 && abs(ticks-50*seconds/2) <= 2;
+    ok = BENCHReport(seekOk,"Seek to half way, %d ticks to the end",ticks) && ok;
+
+    static uint8_t wav[12+12+8+4000+24];                                        // Data before the format, 8 bit mono 8kHz
+    uint8_t chunks[] = { 'L','I','S','T',4,0,0,0,'I','N','F','O','d','a','t','a',0xA0,0x0F,0,0 };
+    uint8_t format[] = { 'f','m','t',' ',16,0,0,0,1,0,1,0,0x40,0x1F,0,0,0x40,0x1F,0,0,1,0,8,0 };
+    memcpy(wav,"RIFF\0\0\0\0WAVE",12);memcpy(wav+12,chunks,sizeof(chunks));
+    memset(wav+32,0x80,4000);memcpy(wav+4032,format,sizeof(format));
+    FIODeleteFile("__order.wav");FIOCreateFile("__order.wav");
+    h = FIOOpen("__order.wav");FIOWrite(h,wav,sizeof(wav));FIOClose(h);
+    err = SNDStreamOpen("__order.wav",0,127,false);
+    for (ticks = 0;SNDStreamIsPlaying() && ticks < 100;ticks++) {
+        SNDStreamTick();SNDRenderBlock(block,perTick);
+    }
+    bool orderOk = err == 0 && abs(ticks-25) <= 2;
+    ok = BENCHReport(orderOk,"WAV with the data chunk before the format, %d ticks",ticks) && ok;
+    FIODeleteFile("__order.wav");
+
+    for (ticks = 0;ticks < 10;ticks++) SNDRenderBlock(block,perTick);           // Starve it, should count underruns.
+    SNDStreamOpen(name,0,127,false);
+    for (ticks = 0;ticks < 2;ticks++) {                                         // Started, then not refilled.
+        SNDStreamTick();SNDRenderBlock(block,perTick);
+    }
+    underruns = SNDStreamUnderruns();
+    for (ticks = 0;ticks < 50;ticks++) SNDRenderBlock(block,perTick);
+    bool starveOk = SNDStreamUnderruns() > underruns;
+    ok = BENCHReport(starveOk,"Underruns counted when not refilled") && ok;
+
+    SNDStreamStop();
+    FIODeleteFile(name);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief      Check a tone keeps its pitch through the simulator's
+ *             resampler, at the hardware rate and several device rates.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHResample(void) {
+    static const int deviceRates[] = { 22050,44100,48000,96000,0 };
+    static const int frequencies[] = { 110,440,1000,3000,0 };
+    int16_t out[512];
+    bool ok = true;
+    for (int f = 0;frequencies[f] != 0;f++) {
+        int8_t sample,last = 0;
+        int hardware = 0;
+        _BENCHSetChannel(0,SNDTYPE_SQUARE,frequencies[f],100);                  // As the hardware would, at its rate.
+        for (int i = 0;i < SNDGetSampleFrequency();i++) {
+            SNDRenderBlock(&sample,1);
+            if (sample > 0 && last <= 0) hardware++;
+            last = sample;
+        }
+        printf("%5dHz : hardware %dHz %5d\n",frequencies[f],SNDGetSampleFrequency(),hardware);
+        for (int r = 0;deviceRates[r] != 0;r++) {                               // Through the resampler
+            int rising = 0,previous = 0;
+            for (int done = 0;done < deviceRates[r]/5;done += 512) {            // Play out the last rate's block
+                SOUNDResample(out,512,deviceRates[r]);
+            }
+            for (int done = 0;done < deviceRates[r];done += 512) {
+                int n = min(512,deviceRates[r]-done);
+                SOUNDResample(out,n,deviceRates[r]);
+                for (int i = 0;i < n;i++) {
+                    if (out[i] > 0 && previous <= 0) rising++;
+                    previous = out[i];
+                }
+            }
+            ok = BENCHReport(abs(rising-hardware) <= 1,"        device %5dHz %5d",deviceRates[r],rising) && ok;
+        }
+    }
+    SNDMuteAllChannels();
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief      Write a little endian value to a file
+ *
+ * @param      f      File
+ * @param[in]  value  Value
+ * @param[in]  bytes  Number of bytes
+ */
+static void _BENCHWriteLE(FILE *f,uint32_t value,int bytes) {
+    while (bytes-- > 0) {
+        fputc(value & 0xFF,f);value >>= 8;
+    }
+}
+
+/**
+ * @brief      Render a song to an 8 bit mono WAV file, a tick at a time,
+ *             and report the player's time per tick.
+ *
+ * @param      song     Song file name, in the simulator storage
+ * @param      wavName  Host WAV file name
+ *
+ * @return     Exit status, 0 if ok.
+ */
+int BENCHRenderMusic(char *song,char *wavName) {
+    static int8_t block[2048];
+    int rate = SNDGetSampleFrequency();
+    int perTick = min((int)sizeof(block),rate/50);
+    int err = MUSLoad(song);
+    if (err == 0) err = MUSPlay(false);
+    if (err != 0) {
+        fprintf(stderr,"Cannot play '%s' (%d)\n",song,err);
+        return 1;
+    }
+    FILE *f = fopen(wavName,"wb");
+    if (f == NULL) {
+        fprintf(stderr,"Cannot create '%s'\n",wavName);
+        return 2;
+    }
+    fwrite("RIFF\0\0\0\0WAVEfmt ",1,16,f);                                    // Sizes are filled in at the end.
+    _BENCHWriteLE(f,16,4);_BENCHWriteLE(f,1,2);_BENCHWriteLE(f,1,2);          // PCM, mono
+    _BENCHWriteLE(f,rate,4);_BENCHWriteLE(f,rate,4);                           // Sample and byte rate
+    _BENCHWriteLE(f,1,2);_BENCHWriteLE(f,8,2);                                 // 8 bit
+    fwrite("data\0\0\0\0",1,8,f);
+
+    int ticks = 0,samples = 0;
+    double total = 0.0,worst = 0.0;
+    bool active = true;
+    while (active && ticks < 50*60*10) {                                        // Until silent, at most 10 minutes
+        double start = BENCHTime();
+        MUSTick();SNDTick();
+        double elapsed = BENCHTime()-start;
+        total += elapsed;worst = max(worst,elapsed);
+        SNDRenderBlock(block,perTick);
+        for (int i = 0;i < perTick;i++) fputc((uint8_t)(block[i]+128),f);
+        samples += perTick;ticks++;
+        active = MUSIsPlaying();
+        for (int c = 0;c < SNDGetChannelCount();c++) active = active || SNDIsChannelPlaying(c);
+    }
+    fseek(f,4,SEEK_SET);_BENCHWriteLE(f,36+samples,4);
+    fseek(f,40,SEEK_SET);_BENCHWriteLE(f,samples,4);
+    fclose(f);
+    printf("Rendered %d ticks (%.2fs) to %s\n",ticks,ticks/50.0,wavName);
+    printf("Player and queues : %.2fus per tick average, %.2fus worst\n",total*1e6/ticks,worst*1e6);
+    return 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file       benchstorage.c
+ *
+ * @brief      Storage checks, the sector cache against a disk image.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+#include "bench.h"
+
+#define BENCH_IMAGE_SECTORS (4096)
+
+static uint8_t diskModel[BENCH_IMAGE_SECTORS][SEC_SECTOR_SIZE];                 // What the disk should hold
+static uint32_t benchSeed = 1;
+
+
+/**
+ * @brief      Repeatable random numbers
+ *
+ * @param[in]  n     Range
+ *
+ * @return     Random number 0..n-1
+ */
+static int _BENCHRandom(int n) {
+    benchSeed = benchSeed * 1103515245 + 12345;
+    return (benchSeed >> 8) % n;
+}
+
+/**
+ * @brief      Sector cache checks, against a disk image. A mix of FAT like,
+ *             sequential and multi-sector accesses is checked against a copy
+ *             of what the disk should hold, then read ahead and write
+ *             coalescing are checked, and the statistics reported.
+ *
+ * @return     Exit status, 1 if any check fails.
+ */
+int BENCHSectorCache(void) {
+    static uint8_t buffer[16*SEC_SECTOR_SIZE];
+    char *name = "storage/__cache.img";
+    SECSTATISTICS st;
+    bool ok = true;
+    if (!DIMOpen(name,BENCH_IMAGE_SECTORS)) {
+        fprintf(stderr,"Cannot create %s\n",name);
+        return 2;
+    }
+    for (int i = 0;i < BENCH_IMAGE_SECTORS;i++) {                               // Each sector different
+        for (int j = 0;j < SEC_SECTOR_SIZE;j++) diskModel[i][j] = i*7+j;
+    }
+    DIMTransfer(0,0,diskModel[0],BENCH_IMAGE_SECTORS,true);
+    SECSetDevice(DIMTransfer,DIMWait,DIMSectorCount);
+    SECInvalidate(0);SECResetStatistics();
+    uint32_t cmd0,read0,written0;
+    DIMGetCounts(&cmd0,&read0,&written0);
+    DIMWait(0);double wait0 = DIMGetWaitTime();                                // Delay (-u) before the test starts
+
+    int requests = 0,errors = 0,cursor = 1000;
+    for (int op = 0;op < 50000;op++) {
+        int r = _BENCHRandom(100),sector,count = 1;
+        bool isWrite = false;
+        if (r < 40) {                                                           // FAT sector read
+            sector = 32+_BENCHRandom(8);
+        } else if (r < 55) {                                                    // FAT sector update
+            sector = 32+_BENCHRandom(8);isWrite = true;
+        } else if (r < 70) {                                                    // Reading through a file or directory
+            sector = cursor++;
+            if (cursor >= BENCH_IMAGE_SECTORS) cursor = 1000;
+        } else if (r < 80) {                                                    // Multi-sector file data
+            count = 2+_BENCHRandom(15);sector = 100+_BENCHRandom(BENCH_IMAGE_SECTORS-120);
+        } else if (r < 90) {
+            count = 2+_BENCHRandom(15);sector = 100+_BENCHRandom(BENCH_IMAGE_SECTORS-120);isWrite = true;
+        } else if (r < 98) {                                                    // Anything else
+            sector = _BENCHRandom(BENCH_IMAGE_SECTORS);isWrite = true;
+        } else {
+            errors += (SECSync(0) != 0);
+            continue;
+        }
+        requests++;
+        if (isWrite) {
+            for (int i = 0;i < count*SEC_SECTOR_SIZE;i++) buffer[i] = _BENCHRandom(256);
+            memcpy(diskModel[sector],buffer,count*SEC_SECTOR_SIZE);
+            errors += (SECWrite(0,sector,buffer,count) != 0);
+        } else {
+            errors += (SECRead(0,sector,buffer,count) != 0);
+            errors += (memcmp(buffer,diskModel[sector],count*SEC_SECTOR_SIZE) != 0);
+        }
+    }
+    errors += (SECSync(0) != 0);
+    for (int i = 0;i < BENCH_IMAGE_SECTORS;i += 16) {                           // Check the image itself.
+        DIMTransfer(0,i,buffer,16,false);
+        errors += (memcmp(buffer,diskModel[i],16*SEC_SECTOR_SIZE) != 0);
+    }
+    SECGetStatistics(&st);
+    ok = BENCHReport(errors == 0,"%d requests, %d errors or differences",requests,errors) && ok;
+    printf("    cache hits %.1f%% of %u single sector reads, %u sectors read ahead\n",
+                100.0*st.hits/max(1,st.hits+st.misses),st.hits+st.misses,st.readAhead);
+    printf("    %u reads, %.2f sectors each, %u writes, %.2f sectors each, largest %u\n",
+                st.readTransfers,(double)st.sectorsRead/max(1,st.readTransfers),
+                st.writeTransfers,(double)st.sectorsWritten/max(1,st.writeTransfers),st.largestTransfer);
+    printf("    %u device transfers for %d requests, %.3fs waiting for the device\n",
+                st.readTransfers+st.writeTransfers,requests,DIMGetWaitTime()-wait0);
+
+    SECInvalidate(0);SECResetStatistics();                                      // Reading sector by sector
+    errors = 0;
+    for (int i = 2000;i < 3024;i++) {
+        errors += (SECRead(0,i,buffer,1) != 0 || memcmp(buffer,diskModel[i],SEC_SECTOR_SIZE) != 0);
+    }
+    SECGetStatistics(&st);
+    bool aheadOk = errors == 0 && st.readTransfers <= 1024/SEC_TRANSFER_SECTORS+2;
+    ok = BENCHReport(aheadOk,"Sequential read of 1024 sectors in %u transfers",st.readTransfers) && ok;
+
+    SECResetStatistics();                                                       // Writing sector by sector
+    for (int i = 0;i < 64;i++) {
+        memset(buffer,i,SEC_SECTOR_SIZE);memcpy(diskModel[3100+i],buffer,SEC_SECTOR_SIZE);
+        errors += (SECWrite(0,3100+i,buffer,1) != 0);
+    }
+    errors += (SECSync(0) != 0);
+    DIMTransfer(0,3100,buffer,16,false);
+    errors += (memcmp(buffer,diskModel[3100],16*SEC_SECTOR_SIZE) != 0);
+    SECGetStatistics(&st);
+    bool writeOk = errors == 0 && st.writeTransfers == 64/SEC_TRANSFER_SECTORS;
+    ok = BENCHReport(writeOk,"Sequential write of 64 sectors in %u transfers",st.writeTransfers) && ok;
+
+    SECInvalidate(0);SECResetStatistics();                                      // Reading up to the last sector
+    errors = 0;
+    for (int i = BENCH_IMAGE_SECTORS-5;i < BENCH_IMAGE_SECTORS;i++) {
+        errors += (SECRead(0,i,buffer,1) != 0 || memcmp(buffer,diskModel[i],SEC_SECTOR_SIZE) != 0);
+    }
+    SECGetStatistics(&st);
+    bool endOk = errors == 0 && st.readTransfers == 2 && st.sectorsRead == 5;
+    ok = BENCHReport(endOk,"Read ahead to the end of the disk, %u sectors in %u transfers",
+                                                        st.sectorsRead,st.readTransfers) && ok;
+
+    SECInvalidate(0);
+    DIMClose();
+    remove(name);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file       capture.c
+ *
+ * @brief      Framebuffer capture and per frame hashing, for comparing
+ *             rendering output.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+
+static FILE *hashLog = NULL;                                                    // Per frame hash log, NULL if off
+static int  captureInterval = 0;                                                // Capture every n frames, 0 if off
+static int  frameNumber = 0;                                                    // Frames rendered
+static int  captureNumber = 0;                                                  // Used to name hotkey captures
+
+/**
+ * @brief      Write a little endian 32 bit value
+ *
+ * @param      f      File
+ * @param[in]  value  Value to write
+ */
+static void _CAPWriteInt(FILE *f,int value) {
+    for (int i = 0;i < 4;i++) fputc((value >> (i*8)) & 0xFF,f);
+}
+
+/**
+ * @brief      Write the display as a PPM file at its native resolution
+ *
+ * @param      f     File
+ */
+static void _CAPWritePPM(FILE *f) {
+    struct DVIModeInformation *dm = DVIGetModeInformation();
+    int colours[640];
+    uint8_t rgb[640*3];
+    fprintf(f,"P6\n%d %d\n255\n",dm->width,dm->height);
+    for (int y = 0;y < dm->height;y++) {
+        RNDDecodeLine(y,colours);
+        for (int x = 0;x < dm->width;x++) {                                     // 12 bit => 24 bit colour.
+            rgb[x*3] = ((colours[x] >> 8) & 0xF) * 17;
+            rgb[x*3+1] = ((colours[x] >> 4) & 0xF) * 17;
+            rgb[x*3+2] = (colours[x] & 0xF) * 17;
+        }
+        fwrite(rgb,3,dm->width,f);
+    }
+}
+
+/**
+ * @brief      Write the raw display. The header is "ARTC", then mode, width,
+ *             height, plane count, plane depth, bytes per line, palette size
+ *             as 32 bit values, the palette as 16 bit 12 bit RGB values and
+ *             the used part of each plane.
+ *
+ * @param      f     File
+ */
+static void _CAPWriteRaw(FILE *f) {
+    struct DVIModeInformation *dm = DVIGetModeInformation();
+    int colours[64];
+    int count = RNDGetPalette(colours);
+    fwrite("ARTC",1,4,f);
+    _CAPWriteInt(f,dm->mode);_CAPWriteInt(f,dm->width);_CAPWriteInt(f,dm->height);
+    _CAPWriteInt(f,dm->bitPlaneCount);_CAPWriteInt(f,dm->bitPlaneDepth);
+    _CAPWriteInt(f,dm->bytesPerLine);_CAPWriteInt(f,count);
+    for (int i = 0;i < count;i++) {
+        fputc(colours[i] & 0xFF,f);fputc(colours[i] >> 8,f);
+    }
+    for (int p = 0;p < dm->bitPlaneCount;p++) {
+        fwrite(dm->bitPlane[p],1,dm->bytesPerLine*dm->height,f);
+    }
+}
+
+/**
+ * @brief      Capture the display to a file, PPM format if the name ends in
+ *             .ppm, raw planes/mode/palette otherwise.
+ *
+ * @param      fileName  Host file name
+ *
+ * @return     true if successful
+ */
+bool CAPWriteImage(char *fileName) {
+    FILE *f = fopen(fileName,"wb");
+    if (f == NULL) return false;
+    int len = strlen(fileName);
+    if (len > 4 && strcmp(fileName+len-4,".ppm") == 0) {
+        _CAPWritePPM(f);
+    } else {
+        _CAPWriteRaw(f);
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * @brief      Hash the display, covers mode, palette and the used part of
+ *             each plane. Works a 64 bit word at a time.
+ *
+ * @return     64 bit hash
+ */
+uint64_t CAPHashDisplay(void) {
+    struct DVIModeInformation *dm = DVIGetModeInformation();
+    int colours[64];
+    uint64_t hash = 0xCBF29CE484222325ULL,word;
+    int count = RNDGetPalette(colours);
+    hash = (hash ^ (uint64_t)dm->mode) * 0x100000001B3ULL;
+    for (int i = 0;i < count;i++) hash = (hash ^ (uint64_t)colours[i]) * 0x100000001B3ULL;
+    int size = dm->bytesPerLine*dm->height;
+    for (int p = 0;p < dm->bitPlaneCount;p++) {
+        uint8_t *data = dm->bitPlane[p];
+        int i;
+        for (i = 0;i+8 <= size;i += 8) {
+            memcpy(&word,data+i,8);
+            hash = (hash ^ word) * 0x100000001B3ULL;
+            hash ^= hash >> 29;
+        }
+        for (;i < size;i++) hash = (hash ^ data[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief      Set up capture options
+ *
+ * @param      hashLogName  File to log per frame hashes to, NULL if none
+ * @param[in]  interval     Capture every interval frames, 0 if never
+ *
+ * @return     true if successful
+ */
+bool CAPOpen(char *hashLogName,int interval) {
+    captureInterval = interval;
+    if (hashLogName != NULL) {
+        hashLog = fopen(hashLogName,"w");
+        if (hashLog == NULL) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief      Capture to the next numbered file, used by the hotkey.
+ */
+void CAPCaptureNext(void) {
+    char name[32];
+    sprintf(name,"capture_%04d.ppm",captureNumber++);
+    CAPWriteImage(name);
+}
+
+/**
+ * @brief      Called after each frame is rendered
+ */
+void CAPEndFrame(void) {
+    frameNumber++;
+    if (hashLog != NULL) {
+        fprintf(hashLog,"%d %016llx\n",frameNumber,(unsigned long long)CAPHashDisplay());
+    }
+    if (captureInterval != 0 && frameNumber % captureInterval == 0) {
+        char name[32];
+        sprintf(name,"frame_%06d.ppm",frameNumber);
+        CAPWriteImage(name);
+    }
+}
+
+/**
+ * @brief      Close capture
+ */
+void CAPClose(void) {
+    if (hashLog != NULL) fclose(hashLog);
+    hashLog = NULL;
+}
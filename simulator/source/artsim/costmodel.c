@@ -0,0 +1,107 @@
+/**
+ * @file       costmodel.c
+ *
+ * @brief      Estimates how many RP2040 cycles each frame would take, from
+ *             the profiling counters and a table of per operation costs.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+
+#define CST_CLOCK       (252000000)                                             // System clock on the hardware
+#define CST_BUDGET      (CST_CLOCK/50)                                          // Cycles available per 50Hz frame
+
+//
+//      Estimated Cortex-M0+ cycles for each counted operation. These are approximations,
+//      intended to show relative cost and trends rather than exact timings.
+//
+static const int costTable[PRF_COUNTERS] = {
+    60,                                                                         // PRF_VDU_BYTES : VDUWrite dispatch
+    250,                                                                        // PRF_PLOT_COMMANDS : scaling, clipping, dispatch
+    80,                                                                         // PRF_TEXT_CHARS : cursor handling (glyphs counted separately)
+    25,                                                                         // PRF_FORTH_OPS : VM fetch, decode and execute
+    0,                                                                          // PRF_AUDIO_UNDERRUNS : not a cost
+    0,                                                                          // PRF_RENDER_TIME : done by the DVI core on the hardware
+    40,                                                                         // PRF_PIXEL_WRITES : dispatch and three read/modify/writes
+    46,                                                                         // PRF_SPAN_BYTES : dispatch, three read/modify/writes, loop
+    20,                                                                         // PRF_GLYPH_BYTES : font lookup, colour mapping, store
+    1,                                                                          // PRF_SCROLL_BYTES : memcpy per byte
+    60                                                                          // PRF_FLOAT_OPS : software floating point
+};
+
+static uint32_t lastCounters[PRF_COUNTERS];                                     // Counters at end of last frame
+static uint32_t lastFrameCycles = 0;                                            // Estimate for the last frame
+static int frameNumber = 0,overBudget = 0,nextWarning = 0;
+static FILE *costLog = NULL;                                                    // Per frame log, NULL if none
+
+/**
+ * @brief      Open the per frame cost log
+ *
+ * @param      logName  Host file name, NULL if none
+ *
+ * @return     true if successful
+ */
+bool CSTOpen(char *logName) {
+    if (logName != NULL) {
+        costLog = fopen(logName,"w");
+        if (costLog == NULL) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief      Called once per frame, work out the estimated cycles for that
+ *             frame and warn if it is over budget.
+ */
+void CSTEndFrame(void) {
+    uint64_t cycles = 0;
+    frameNumber++;
+    for (int i = 0;i < PRF_COUNTERS;i++) {
+        uint32_t now = PRFReadCounter(i);
+        cycles += (uint64_t)(now-lastCounters[i]) * costTable[i];
+        lastCounters[i] = now;
+    }
+    lastFrameCycles = (cycles > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)cycles;
+    if (costLog != NULL) {
+        fprintf(costLog,"%d %u %u%%\n",frameNumber,lastFrameCycles,CSTGetBudgetPercent());
+    }
+    if (lastFrameCycles > CST_BUDGET) {                                         // Over budget, warn at most once a second.
+        overBudget++;
+        if (TMRReadTimeMS() >= nextWarning) {
+            fprintf(stderr,"Frame %d estimated at %u cycles, %u%% of the hardware budget (%d frames over)\n",
+                                            frameNumber,lastFrameCycles,CSTGetBudgetPercent(),overBudget);
+            nextWarning = TMRReadTimeMS()+1000;
+        }
+    }
+}
+
+/**
+ * @brief      Get the estimated cycles for the last frame
+ *
+ * @return     Estimated RP2040 cycles
+ */
+uint32_t CSTGetFrameCycles(void) {
+    return lastFrameCycles;
+}
+
+/**
+ * @brief      Get the last frame's estimate as a percentage of the budget
+ *
+ * @return     Percentage, may be over 100
+ */
+unsigned int CSTGetBudgetPercent(void) {
+    return (unsigned int)((uint64_t)lastFrameCycles * 100 / CST_BUDGET);
+}
+
+/**
+ * @brief      Close the cost model, reporting frames over budget
+ */
+void CSTClose(void) {
+    if (costLog != NULL) fclose(costLog);
+    costLog = NULL;
+    if (overBudget != 0) printf("%d of %d frames over the hardware budget\n",overBudget,frameNumber);
+}
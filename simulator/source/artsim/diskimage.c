@@ -0,0 +1,148 @@
+/**
+ * @file       diskimage.c
+ *
+ * @brief      Disk image file used as a storage device, so the sector cache
+ *             (and FatFS) can be run and measured on the host. Transfers can
+ *             be given a delay like a USB key's, which is waited for in
+ *             DIMWait(), so writes that are not waited for still overlap.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+
+static FILE *image = NULL;
+static uint32_t sectorCount = 0;
+static uint32_t commands,sectorsRead,sectorsWritten;
+static int commandDelay = 0,sectorDelay = 0;                                    // Latency in microseconds
+static double readyTime = 0.0;                                                  // When the last transfer finishes
+static double waitTime = 0.0;                                                   // Total time spent waiting
+
+/**
+ * @brief      Get the time
+ *
+ * @return     Time in seconds
+ */
+static double _DIMTime(void) {
+    return (double)SDL_GetPerformanceCounter()/(double)SDL_GetPerformanceFrequency();
+}
+
+/**
+ * @brief      Set the delay for each transfer
+ *
+ * @param[in]  command  Microseconds per transfer
+ * @param[in]  sector   Microseconds per sector transferred
+ */
+void DIMSetLatency(int command,int sector) {
+    commandDelay = max(0,command);sectorDelay = max(0,sector);
+}
+
+/**
+ * @brief      Open a disk image
+ *
+ * @param      fileName  The image file
+ * @param[in]  create    If non zero, create a zeroed image of this many
+ *                       sectors
+ *
+ * @return     true if opened
+ */
+bool DIMOpen(char *fileName,int create) {
+    static uint8_t zero[SEC_SECTOR_SIZE];
+    DIMClose();
+    image = fopen(fileName,create > 0 ? "w+b" : "r+b");
+    if (image == NULL) return false;
+    for (int i = 0;i < create;i++) fwrite(zero,1,SEC_SECTOR_SIZE,image);
+    fseek(image,0,SEEK_END);
+    sectorCount = ftell(image) / SEC_SECTOR_SIZE;
+    commands = sectorsRead = sectorsWritten = 0;
+    waitTime = readyTime = 0.0;
+    return true;
+}
+
+/**
+ * @brief      Close the disk image
+ */
+void DIMClose(void) {
+    if (image != NULL) fclose(image);
+    image = NULL;
+}
+
+/**
+ * @brief      Get the size of the disk image
+ *
+ * @param[in]  drive  The drive (ignored)
+ *
+ * @return     Number of sectors
+ */
+uint32_t DIMSectorCount(uint8_t drive) {
+    return (image == NULL) ? 0 : sectorCount;
+}
+
+/**
+ * @brief      Read or write sectors. The data is transferred before it
+ *             returns, any delay happens in DIMWait().
+ *
+ * @param[in]  drive    The drive (ignored)
+ * @param[in]  sector   First sector
+ * @param      buffer   The data
+ * @param[in]  count    Number of sectors
+ * @param[in]  isWrite  true to write
+ *
+ * @return     0 or error code
+ */
+int DIMTransfer(uint8_t drive,uint32_t sector,uint8_t *buffer,int count,bool isWrite) {
+    if (image == NULL || count <= 0 || sector+count > sectorCount) return FIO_ERR_SYSTEM;
+    commands++;
+    if (commandDelay != 0 || sectorDelay != 0) {                                // Work out when it would finish.
+        readyTime = max(_DIMTime(),readyTime) + (commandDelay + sectorDelay * count) / 1e6;
+    }
+    if (fseek(image,(long)sector*SEC_SECTOR_SIZE,SEEK_SET) != 0) return FIO_ERR_SYSTEM;
+    size_t done;
+    if (isWrite) {
+        done = fwrite(buffer,SEC_SECTOR_SIZE,count,image);
+        sectorsWritten += count;
+    } else {
+        done = fread(buffer,SEC_SECTOR_SIZE,count,image);
+        sectorsRead += count;
+    }
+    return (done == (size_t)count) ? 0 : FIO_ERR_SYSTEM;
+}
+
+/**
+ * @brief      Wait until the last transfer would have finished.
+ *
+ * @param[in]  drive  The drive
+ *
+ * @return     0
+ */
+int DIMWait(uint8_t drive) {
+    double now = _DIMTime();
+    if (now < readyTime) {
+        waitTime += readyTime-now;
+        while (_DIMTime() < readyTime) usleep(50);
+    }
+    return 0;
+}
+
+/**
+ * @brief      Get the time spent waiting for transfers
+ *
+ * @return     Time in seconds
+ */
+double DIMGetWaitTime(void) {
+    return waitTime;
+}
+
+/**
+ * @brief      Get the number of transfers and sectors since opening
+ *
+ * @param      pCommands  Transfers
+ * @param      pRead      Sectors read
+ * @param      pWritten   Sectors written
+ */
+void DIMGetCounts(uint32_t *pCommands,uint32_t *pRead,uint32_t *pWritten) {
+    *pCommands = commands;*pRead = sectorsRead;*pWritten = sectorsWritten;
+}
@@ -24,9 +24,28 @@ static FILE *files[FIO_MAX_HANDLES];
 
 
 /**
- * @brief      Reset all file objects etc.
+ * @brief      Carry out asynchronous file requests, so the main thread does
+ *             not wait for them.
+ *
+ * @param      data  Not used
+ *
+ * @return     0
+ */
+static int _FSYSAsyncWorker(void *data) {
+    while (true) {
+        if (!FIOAsyncStep()) SDL_Delay(1);                                          // Nothing to do, so wait a bit.
+    }
+    return 0;
+}
+
+/**
+ * @brief      Reset all file objects etc., and start the worker thread for
+ *             asynchronous requests.
  */
 void FSYSInitialise(void) {
+    static SDL_Thread *worker = NULL;
+    if (worker == NULL) worker = SDL_CreateThread(_FSYSAsyncWorker,"fileio",NULL);
+    FIOAsyncSetWorker(worker != NULL);
 }
 /**
  * @brief      Map the internal error value onto FIO type error
@@ -40,6 +59,8 @@ static int _FSYSMapError(void) {
             e = 0;break;
         case ENOENT:
             e = FIO_ERR_NOTFOUND;break;
+        case EEXIST:
+            e = FIO_ERR_EXISTS;break;
         default:
             e = FIO_ERR_SYSTEM;break;
     }
@@ -157,7 +178,19 @@ int FSYSDeleteDirectory(char *name) {
 }                                           
 
 /**
- * @brief      Open File in R/W mode, rewind to start
+ * @brief      Set the current directory. The host file system is not told,
+ *             names are mapped onto the directory by FIOMapFileName().
+ *
+ * @param      directory  The absolute directory
+ *
+ * @return     false, relative names must be mapped.
+ */
+bool FSYSSetDirectory(char *directory) {
+    return false;
+}
+
+/**
+ * @brief      Open File in R/W mode, at the start
  *
  * @param[in]  handle  The handle to use
  * @param      name    The name of the file.
@@ -165,11 +198,34 @@ int FSYSDeleteDirectory(char *name) {
  * @return     Error code if non-zero
  */
 int FSYSOpen(int handle,char *name) {
-    files[handle] = fopen(_FSYSMapName(name),"r+");                                 // Open read/write
+    return FSYSOpenEx(handle,name,FIO_OPEN_READWRITE);
+};
+
+/**
+ * @brief      Open File in one of the FIO_OPEN modes
+ *
+ * @param[in]  handle  The handle to use
+ * @param      name    The name of the file.
+ * @param[in]  mode    The FIO_OPEN mode
+ *
+ * @return     Error code if non-zero
+ */
+int FSYSOpenEx(int handle,char *name,int mode) {
+    static const char *stdioModes[] = { "r+","r","w+","wx+","r+" };                 // Append is "r+" at the end, not "a+"
+    if (mode < 0 || mode > FIO_OPEN_APPEND) return FIO_ERR_COMMAND;
+    name = _FSYSMapName(name);
+    files[handle] = fopen(name,stdioModes[mode]);
+    if (files[handle] == NULL && mode == FIO_OPEN_APPEND && errno == ENOENT) {      // Appending creates the file
+        files[handle] = fopen(name,"w+");
+    }
     if (files[handle] == NULL) return _FSYSMapError();                              // Open failed.
-    if (fseek(files[handle],0,SEEK_SET) < 0) return _FSYSMapError();                // Rewind it.
+    if (mode == FIO_OPEN_APPEND && fseek(files[handle],0,SEEK_END) < 0) {           // Move to the end
+        int err = _FSYSMapError();
+        fclose(files[handle]);
+        return err;
+    }
     return FIO_OK;
-};
+}
 
 /**
  * @brief      Close the file
@@ -242,45 +298,84 @@ int FSYSGetSetPosition(int handle,int newPosition) {
     return current;
 }   
 
-static DIR* currentDirectory;
+/**
+ * @brief      Get the size of an open file
+ *
+ * @param[in]  handle  The handle
+ *
+ * @return     Size in bytes, or Error code if negative
+ */
+int FSYSFileSize(int handle) {
+    struct stat ffi;
+    fflush(files[handle]);                                                          // Include anything stdio is holding.
+    if (fstat(fileno(files[handle]),&ffi) != 0) return _FSYSMapError();
+    return ffi.st_size;
+}
+
+/**
+ * @brief      Allocate space for an empty file that is about to be written.
+ *             The host file system does this itself, so it does nothing.
+ *
+ * @param[in]  handle  The handle
+ * @param[in]  size    The size in bytes
+ *
+ * @return     Error code if non-zero
+ */
+int FSYSPreallocate(int handle,int size) {
+    return FIO_OK;
+}
+
+static DIR* directories[FIO_MAX_DIRECTORIES];                                       // Directories being read.
 
 /**
  * @brief      Opens directory to be read
  *
+ * @param[in]  handle     The directory handle to use
  * @param      directory  The directory to be read
  *
  * @return     Error code if non-zero
  */
-int FSYSOpenDirectory(char *directory) {
+int FSYSOpenDirectory(int handle,char *directory) {
     directory = _FSYSMapName(directory);                                            // Map directory
-    currentDirectory = opendir(directory);                                          // Open directory.    
-    return (currentDirectory == NULL) ? _FSYSMapError() : FIO_OK;                   // Return OK, or error.
+    directories[handle] = opendir(directory);                                       // Open directory.    
+    return (directories[handle] == NULL) ? _FSYSMapError() : FIO_OK;                // Return OK, or error.
 }
 
 /**
- * @brief      Read next directory entry
+ * @brief      Read next directory entry, with its size and type. Entries
+ *             which cannot be examined (e.g. broken links) are skipped.
  *
- * @param      fileName  The file name read from the directory
+ * @param[in]  handle  The directory handle
+ * @param      info    Information about the entry
  *
- * @return     Error code if non-zero
+ * @return     Error code if non-zero, FIO_EOF at the end.
  */
-int FSYSReadDirectory(char *fileName) {
-    struct dirent *next = readdir(currentDirectory);                                // Read next entry.
-    if (next == NULL) {                                                             // Read failed.
-        if (errno == 0) return FIO_EOF;                                             // End of directory
-        return _FSYSMapError();                                                     // All other errors.
-    }
+int FSYSReadDirectory(int handle,FIOInfo *info) {
+    struct dirent *next;
+    struct stat ffi;
+    do {
+        errno = 0;
+        next = readdir(directories[handle]);                                        // Read next entry.
+        if (next == NULL) {                                                         // Read failed.
+            if (errno == 0) return FIO_EOF;                                         // End of directory
+            return _FSYSMapError();                                                 // All other errors.
+        }
+    } while (fstatat(dirfd(directories[handle]),next->d_name,&ffi,0) != 0);         // Relative to the directory, no path walk.
     int toCopy = min(MAX_FILENAME_SIZE,strlen(next->d_name));
-    for (int i = 0;i < toCopy;i++) fileName[i] = next->d_name[i];
-    fileName[toCopy] = '\0';
+    for (int i = 0;i < toCopy;i++) info->name[i] = next->d_name[i];
+    info->name[toCopy] = '\0';
+    info->isDirectory = S_ISDIR(ffi.st_mode);
+    info->length = info->isDirectory ? 0 : ffi.st_size;                             // Length if file, 0 for directory.
     return FIO_OK;
 }   
 
 /**
  * @brief      Close directory being read
  *
+ * @param[in]  handle  The directory handle
+ *
  * @return     Error code if non-zero
  */
-int FSYSCloseDirectory(void) {
-    return closedir(currentDirectory) < 0 ? _FSYSMapError() : FIO_OK;
+int FSYSCloseDirectory(int handle) {
+    return closedir(directories[handle]) < 0 ? _FSYSMapError() : FIO_OK;
 }
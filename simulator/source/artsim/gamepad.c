@@ -73,6 +73,16 @@ CTLState *CTLReadController(int n) {
 }
 
 
+/**
+ * @brief      Queue events for any controllers that have changed, called
+ *             each frame after SDL events are processed.
+ */
+void CTLCheckControllers(void) {
+    for (int i = 0;i < controllerCount;i++) {
+        EVTControllerState(i,CTLReadController(i));
+    }
+}
+
 /**
  * @brief      Look for controllers iplugged into the system.
  */
@@ -0,0 +1,82 @@
+/**
+ * @file       hud.c
+ *
+ * @brief      Performance overlay, toggled with F11, composited over the top
+ *             left of the display.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+
+#define HUD_LINES       (9)                                                     // Lines displayed
+#define HUD_WIDTH       (28)                                                    // Characters per line
+#define HUD_PERIOD      (1000)                                                  // Update period in ms
+
+static bool hudVisible = false;
+static char hudText[HUD_LINES][HUD_WIDTH+1];                                    // Text currently displayed.
+static uint32_t lastCounters[PRF_COUNTERS];                                     // Counters at last update
+static int lastUpdate = 0,frames = 0;                                           // Last update time, frames since.
+
+/**
+ * @brief      Toggle the overlay on and off
+ */
+void HUDToggle(void) {
+    hudVisible = !hudVisible;
+}
+
+/**
+ * @brief      Recalculate the rates, once a second
+ */
+static void _HUDRecalculate(void) {
+    uint32_t delta[PRF_COUNTERS];
+    int elapsed = TMRReadTimeMS()-lastUpdate;
+    for (int i = 0;i < PRF_COUNTERS;i++) {                                      // Work out changes in each counter
+        delta[i] = PRFReadCounter(i)-lastCounters[i];
+        lastCounters[i] = PRFReadCounter(i);
+    }
+    #define RATE(n) ((unsigned int)((uint64_t)(n) * 1000 / elapsed))
+    snprintf(hudText[0],HUD_WIDTH+1,"FPS        %u",RATE(frames));
+    snprintf(hudText[1],HUD_WIDTH+1,"VDU bytes  %u/s",RATE(delta[PRF_VDU_BYTES]));
+    snprintf(hudText[2],HUD_WIDTH+1,"PLOTs      %u/s",RATE(delta[PRF_PLOT_COMMANDS]));
+    snprintf(hudText[3],HUD_WIDTH+1,"Text chars %u/s",RATE(delta[PRF_TEXT_CHARS]));
+    snprintf(hudText[4],HUD_WIDTH+1,"Forth ops  %u/s",RATE(delta[PRF_FORTH_OPS]));
+    snprintf(hudText[5],HUD_WIDTH+1,"Callback   %u underruns",SOUNDGetUnderruns());
+    snprintf(hudText[6],HUD_WIDTH+1,"Stream     %u underruns",PRFReadCounter(PRF_AUDIO_UNDERRUNS));
+    snprintf(hudText[7],HUD_WIDTH+1,"Render     %u us/frame",frames == 0 ? 0 : (unsigned int)(delta[PRF_RENDER_TIME] / frames));
+    snprintf(hudText[8],HUD_WIDTH+1,"RP2040     %u%% of frame",CSTGetBudgetPercent());
+    #undef RATE
+    lastUpdate = TMRReadTimeMS();
+    frames = 0;
+}
+
+/**
+ * @brief      Called once per frame after rendering, update and draw the
+ *             overlay.
+ */
+void HUDEndFrame(void) {
+    SDL_Rect rc;
+    frames++;
+    if (TMRReadTimeMS()-lastUpdate >= HUD_PERIOD) _HUDRecalculate();
+    if (!hudVisible) return;
+
+    rc.x = 8;rc.y = 8;rc.w = HUD_WIDTH*8+8;rc.h = HUD_LINES*10+8;               // Background box.
+    SYSRectangle(&rc,0x000);
+    rc.w = rc.h = 1;
+    for (int line = 0;line < HUD_LINES;line++) {
+        for (int c = 0;hudText[line][c] != '\0';c++) {
+            for (int y = 0;y < 8;y++) {
+                uint8_t pixels = VDUGetCharacterLineData(hudText[line][c],y);
+                for (int x = 0;x < 8;x++) {
+                    if (pixels & (0x80 >> x)) {
+                        rc.x = 12+c*8+x;rc.y = 12+line*10+y;
+                        SYSRectangle(&rc,0x0F0);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -17,6 +17,11 @@ bool isAppRunning = true;
 #define FRAME_RATE  (50)
 
 static int nextUpdateTime = 0;
+static int exitStatus = -1;                                                     // Exit status if forced, -1 if not.
+static int timeOutTime = 0;                                                     // Time out (ms) 0 if none.
+static bool isScripted = false;                                                 // Playing a keystroke script.
+
+#define ARTSIM_DEFAULT_IMAGE    "storage.img"
 
 /**
  * @brief      Is the app still running (for simulator)
@@ -27,6 +32,16 @@ bool SYSAppRunning(void) {
     return isAppRunning;
 }
 
+/**
+ * @brief      Stop the application, and exit the simulator with the given
+ *             status when it returns.
+ *
+ * @param[in]  status  The exit status
+ */
+void SYSRequestExit(int status) {
+    exitStatus = status;
+    isAppRunning = false;
+}
 
 /**
  * @brief      Yield, body executed at 50Hz
@@ -34,31 +49,149 @@ bool SYSAppRunning(void) {
  * @return     true if 50Hz tick occurred.
  */
 bool SYSYield(void) {
+    FIOAsyncTick();                                                             // Callbacks for file requests
     if (TMRReadTimeMS() >= nextUpdateTime) {                                    // So do this to limit the repaint rate to 50Hz.
-        nextUpdateTime = TMRReadTimeMS()+100/FRAME_RATE;
+        nextUpdateTime = TMRReadTimeMS()+1000/FRAME_RATE;
         if (SYSPollUpdate() == 0) isAppRunning = false;
         KBDCheckTimer();                                                        // Check for keyboard repeat
+        MUSTick();                                                              // Advance any music
+        SNDTick();                                                              // Play queued notes
+        SNDStreamTick();                                                        // Refill any sound being streamed
+        SCRUpdate();                                                            // Play any keystroke script
+        if (isScripted && SCRIsComplete() && isAppRunning) {                    // Played out without a quit.
+            SYSRequestExit(0);
+        }
+        if (timeOutTime != 0 && TMRReadTimeMS() >= timeOutTime) {               // Timed out ?
+            fprintf(stderr,"Timed out\n");
+            SYSRequestExit(3);
+        }
         return true;
     }
     return false;
 }
 
+/**
+ * @brief      Display usage and exit
+ *
+ * @param      name  Executable name
+ */
+static void _SYSUsage(char *name) {
+    fprintf(stderr,"Usage: %s [-m] [-k script] [-t seconds] [-l hashlog] [-c frames] [-e costlog] [-b benchmark] [-r wavfile] [-d image] [-u delay] [command ...]\n",name);
+    fprintf(stderr,"    -m          mute sound\n");
+    fprintf(stderr,"    -k script   play keystroke script file, exit with status 0 at its end\n");
+    fprintf(stderr,"    -t seconds  exit with status 3 if not finished in time\n");
+    fprintf(stderr,"    -l hashlog  log a hash of the display every frame\n");
+    fprintf(stderr,"    -c frames   capture the display every n frames\n");
+    fprintf(stderr,"    -e costlog  log estimated RP2040 cycles every frame\n");
+    fprintf(stderr,"    -b name     run a host benchmark and exit, -b list shows them\n");
+    fprintf(stderr,"    -r wavfile  render the music file given as the command to a WAV file\n");
+    fprintf(stderr,"    -d image    FAT disk image to use (FATFS=1 builds), default %s\n",ARTSIM_DEFAULT_IMAGE);
+    fprintf(stderr,"    -u cmd[,sec] disk image delay in microseconds per transfer and per sector\n");
+    fprintf(stderr,"    command     run this command then exit, status 1 if not recognised\n");
+    exit(2);
+}
+
 /**
  * @brief      Main program.
  *
  * @param[in]  argc  The count of arguments
  * @param      argv  The arguments array
  *
- * @return     { description_of_the_return_value }
+ * @return     Exit status, 0 if ok.
  */
 int main(int argc,char *argv[]) {
+    int opt;
+    bool muteSound = false;
+    char *scriptName = NULL;
+    int timeOut = 0;
+    char *hashLogName = NULL;
+    int captureInterval = 0;
+    char *costLogName = NULL;
+    char *wavName = NULL;
+    char *benchName = NULL;
+    char *imageName = NULL;
+    static char command[256];
+
+    while ((opt = getopt(argc,argv,"mk:t:l:c:e:b:r:d:u:")) != -1) {                  // Process options
+        switch(opt) {
+            case 'm':
+                muteSound = true;break;
+            case 'k':
+                scriptName = optarg;break;
+            case 't':
+                timeOut = atoi(optarg);break;
+            case 'l':
+                hashLogName = optarg;break;
+            case 'c':
+                captureInterval = atoi(optarg);break;
+            case 'e':
+                costLogName = optarg;break;
+            case 'b':
+                benchName = optarg;break;
+            case 'r':
+                wavName = optarg;break;
+            case 'd':
+                imageName = optarg;break;
+            case 'u': {
+                char *sector = strchr(optarg,',');
+                DIMSetLatency(atoi(optarg),sector == NULL ? 0 : atoi(sector+1));
+                break;
+            }
+            default:
+                _SYSUsage(argv[0]);
+        }
+    }
+    command[0] = '\0';                                                              // Build the command from what's left.
+    for (int i = optind;i < argc;i++) {
+        if (strlen(command)+strlen(argv[i])+2 >= sizeof(command)) _SYSUsage(argv[0]);
+        if (i != optind) strcat(command," ");
+        strcat(command,argv[i]);
+    }
+    #ifndef ARTSIM_FATFS
+    if (imageName != NULL) {
+        fprintf(stderr,"Disk images need a FATFS=1 build\n");
+        exit(2);
+    }
+    #endif
+    #ifdef ARTSIM_FATFS
+    if (imageName == NULL) imageName = ARTSIM_DEFAULT_IMAGE;
+    bool isOwnImage = (benchName != NULL && BENCHUsesOwnImage(benchName));         // sectorcache opens its own.
+    if (!isOwnImage && !FATMount(imageName)) {                                      // FatFS on a disk image
+        fprintf(stderr,"Cannot mount disk image '%s'\n",imageName);
+        exit(2);
+    }
+    #endif
+    if (benchName != NULL) exit(BENCHRun(benchName));                               // Run a benchmark, on the image if FatFS.
+    if (wavName != NULL) {                                                          // Render music, needs the file system
+        if (optind >= argc) _SYSUsage(argv[0]);
+        FIOInitialise();
+        exit(BENCHRenderMusic(command,wavName));
+    }
+    if (scriptName != NULL && !SCROpen(scriptName)) {                               // Open the script if there is one
+        fprintf(stderr,"Cannot open script '%s'\n",scriptName);
+        exit(2);
+    }
+    isScripted = (scriptName != NULL);
+    if (!CAPOpen(hashLogName,captureInterval)) {                                    // Set up display capture
+        fprintf(stderr,"Cannot create hash log '%s'\n",hashLogName);
+        exit(2);
+    }
+    if (!CSTOpen(costLogName)) {                                                    // Set up the cost model log
+        fprintf(stderr,"Cannot create cost log '%s'\n",costLogName);
+        exit(2);
+    }
+
     VDUWrite(22);VDUWrite(DVI_MODE_640_240_8);                                      // Initialise display
-    HDRDisplay();                                                                   // Display header    
+    HDRDisplay();                                                                   // Display header
     CONWriteString("Simulator booting\r\n\r\n");
     KBDReceiveEvent(0,0xFF,0);                                                      // Initialise keyboard manager
     FIOInitialise();                                                                // Initialise file system
-    SYSOpen(false);                                                                 // Start SDL and Mouse/Controller/Sound that use it
-    ApplicationRun();                                                               // Run the program
+    SYSOpen(muteSound);                                                             // Start SDL and Mouse/Controller/Sound that use it
+    if (timeOut != 0) timeOutTime = TMRReadTimeMS()+timeOut*1000;
+    int status = ApplicationRun(optind < argc ? command : NULL);                    // Run the program
     SYSClose();                                                                     // Close down
-    return(0);
+    #ifdef ARTSIM_FATFS
+    FATUnmount();
+    #endif
+    return (exitStatus >= 0) ? exitStatus : status;
 }
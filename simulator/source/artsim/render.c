@@ -18,6 +18,9 @@ static uint8_t bluePlane[640*480/8];
 static struct DVIModeInformation dvi_modeInfo;
 static int mode = DVI_MODE_640_240_8;
 
+static bool showHeatMap = false;                                                    // Show the write heat map
+static uint8_t heatMap[PRF_WRITE_MAP_SIZE];                                         // Decaying write counts
+
 
 //
 //                            Mode Palettes
@@ -139,14 +142,106 @@ int  DVIGetScreenExtent(int *pWidth,int *pHeight) {
     return dvi_modeInfo.mode;
 }
 
+/**
+ * @brief      Get the palette currently in use, as 12 bit RGB values
+ *
+ * @param      colours  Array of at least 64 entries to fill
+ *
+ * @return     Number of palette entries
+ */
+int RNDGetPalette(int *colours) {
+    struct DVIModeInformation *dm = DVIGetModeInformation();
+    if (dm->bitPlaneDepth == 2) {                                                   // 64 colour modes
+        memcpy(colours,palette_64,sizeof(palette_64));
+        return 64;
+    }
+    if (dm->bitPlaneCount == 1) {                                                   // Monochrome, 0 is the foreground
+        colours[0] = palette[palette_mono[0]];colours[1] = palette[palette_mono[1]];
+        return 2;
+    }
+    memcpy(colours,palette,sizeof(palette));
+    return 8;
+}
+
+/**
+ * @brief      Decode one line of the display into 12 bit RGB values
+ *
+ * @param[in]  y        Line number
+ * @param      colours  Array of (width) entries to fill
+ */
+void RNDDecodeLine(int y,int *colours) {
+    struct DVIModeInformation *dm = DVIGetModeInformation();
+    uint8_t *pr,*pg,*pb,r,g,b;
+    pr = dm->bitPlane[0]+y*dm->bytesPerLine;
+    pg = dm->bitPlane[1]+y*dm->bytesPerLine;
+    pb = dm->bitPlane[2]+y*dm->bytesPerLine;
+    for (int x = 0;x < dm->width;x+= 8/dm->bitPlaneDepth) {
+        r = *pr++;g = *pg++;b = *pb++;
+        if (dm->bitPlaneDepth == 1) {
+            for (int bt = 0;bt < 8;bt++) {
+                uint8_t c = ((r & 0x80) >> 7)+((g & 0x80) >> 6)+((b & 0x80) >> 5);
+                if (dm->bitPlaneCount == 1) c = (r & 0x80) ? palette_mono[0] : palette_mono[1];
+                *colours++ = palette[c];
+                r <<= 1;g <<= 1;b <<= 1;
+            }
+        } else {
+            for (int bt = 0;bt < 4;bt++) {
+                uint8_t c = ((r & 0xC0) >> 6)+((g & 0xC0) >> 4)+((b & 0xC0) >> 2);
+                *colours++ = palette_64[c];
+                r <<= 2;g <<= 2;b <<= 2;
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Toggle the write heat map display
+ */
+void RNDToggleHeatMap(void) {
+    showHeatMap = !showHeatMap;
+}
+
+/**
+ * @brief      Fold the writes since the last frame into the heat map, with
+ *             decay, and clear them.
+ */
+static void _RNDUpdateHeatMap(void) {
+    uint8_t *writes = PRFGetWriteMap();
+    for (int i = 0;i < PRF_WRITE_MAP_SIZE;i++) {
+        int heat = heatMap[i] - ((heatMap[i]+7) >> 3) + writes[i] * 32;             // Decay by 1/8 per frame.
+        heatMap[i] = min(heat,255);
+        writes[i] = 0;
+    }
+}
+
+/**
+ * @brief      Tint a colour according to its heat, dimmed if not written
+ *             recently, red through yellow the more it is written
+ *
+ * @param[in]  colour  12 bit colour
+ * @param[in]  heat    Heat 0-255
+ *
+ * @return     12 bit colour
+ */
+static int _RNDHeatColour(int colour,int heat) {
+    int r = ((colour >> 8) & 0xF) / 4,g = ((colour >> 4) & 0xF) / 4,b = (colour & 0xF) / 4;
+    if (heat != 0) {
+        r = max(r,4 + heat * 11 / 255);
+        if (heat > 128) g = max(g,(heat-128) >> 3);
+    }
+    return (r << 8) | (g << 4) | b;
+}
+
 /**
  * @brief      Render the display
  *
  * @param      surface  The surface to render it on
  */
-void RNDRender(SDL_Surface *surface) {  
+void RNDRender(SDL_Surface *surface) {
     struct DVIModeInformation *dm = DVIGetModeInformation();
-    uint8_t *pr,*pg,*pb,r,g,b;
+    int colours[640];
+    int pixelsPerByte = 8 / dm->bitPlaneDepth;
+    _RNDUpdateHeatMap();
     SDL_Rect rc;
     rc.x = rc.y = 0;rc.w = AS_SCALE*640+16;rc.h = AS_SCALE*480+16;
     SYSRectangle(&rc,0);
@@ -154,28 +249,14 @@ void RNDRender(SDL_Surface *surface) {
         rc.w = AS_SCALE * 640/dm->width;
         rc.h = AS_SCALE * 480/dm->height;
         rc.y = y*rc.h+8;
-        pr = dm->bitPlane[0]+y*dm->bytesPerLine;
-        pg = dm->bitPlane[1]+y*dm->bytesPerLine;
-        pb = dm->bitPlane[2]+y*dm->bytesPerLine;
-        for (int x = 0;x < dm->width;x+= 8/dm->bitPlaneDepth) {
+        RNDDecodeLine(y,colours);
+        if (showHeatMap) {                                                          // Tint with the heat map.
+            uint8_t *heat = heatMap + y*dm->bytesPerLine;
+            for (int x = 0;x < dm->width;x++) colours[x] = _RNDHeatColour(colours[x],heat[x/pixelsPerByte]);
+        }
+        for (int x = 0;x < dm->width;x++) {
             rc.x = x*rc.w+8;
-            r = *pr++;g = *pg++;b = *pb++;
-            if (dm->bitPlaneDepth == 1) {
-                for (int bt = 0;bt < 8;bt++) {
-                    uint8_t c = ((r & 0x80) >> 7)+((g & 0x80) >> 6)+((b & 0x80) >> 5);
-                    if (dm->bitPlaneCount == 1) c = (r & 0x80) ? palette_mono[0] : palette_mono[1];
-                    SYSRectangle(&rc,palette[c]);
-                    r <<= 1;g <<= 1;b <<= 1;
-                    rc.x += rc.w;
-                }
-            } else {
-                for (int bt = 0;bt < 8;bt++) {
-                    uint8_t c = ((r & 0xC0) >> 6)+((g & 0xC0) >> 4)+((b & 0xC0) >> 2);
-                    SYSRectangle(&rc,palette_64[c]);
-                    r <<= 2;g <<= 2;b <<= 2;
-                    rc.x += rc.w;         
-                }       
-            }
+            SYSRectangle(&rc,colours[x]);
         }
-    } 
+    }
 }
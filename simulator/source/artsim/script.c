@@ -0,0 +1,115 @@
+/**
+ * @file       script.c
+ *
+ * @brief      Keystroke script player, feeds timed input to the keyboard
+ *             system so the simulator can be run unattended.
+ *
+ * @author     Paul Robson
+ *
+ * @date       19/10/2026
+ *
+ */
+
+#include "artsim.h"
+
+//
+//      Script format, one command per line, blank lines and lines starting with # are ignored.
+//
+//      wait <ms>               pause before the next command
+//      type <text>             queue text as keystrokes
+//      line <text>             queue text followed by RETURN
+//      key <code> [mods]       press and release a USB key code, with optional modifier bits
+//      down <code> [mods]      press a USB key code
+//      up <code> [mods]        release a USB key code
+//      capture <file>          capture the display, PPM if the name ends in .ppm, raw otherwise
+//      hash                    print a hash of the display to stdout
+//      quit [status]           end the simulation with the given exit status
+//
+
+#define SCR_LINE_SIZE   (256)                                                   // Longest script line
+
+static FILE *scriptFile = NULL;                                                 // Script being played, NULL if none
+static int  resumeTime = 0;                                                     // Time when the next command can run.
+static char pendingText[SCR_LINE_SIZE+2];                                       // Text waiting to go into the queue
+static int  pendingPos = 0;
+
+/**
+ * @brief      Open a keystroke script
+ *
+ * @param      fileName  Host file name of the script
+ *
+ * @return     true if opened successfully.
+ */
+bool SCROpen(char *fileName) {
+    scriptFile = fopen(fileName,"r");
+    pendingText[0] = '\0';pendingPos = 0;
+    resumeTime = 0;
+    return scriptFile != NULL;
+}
+
+/**
+ * @brief      Check if the script has completed
+ *
+ * @return     true if there is no script, or it has all been played
+ */
+bool SCRIsComplete(void) {
+    return scriptFile == NULL && pendingText[pendingPos] == '\0';
+}
+
+/**
+ * @brief      Execute a single script line
+ *
+ * @param      line  The line, stripped of its line ending
+ */
+static void _SCRExecute(char *line) {
+    char *params = line;
+    while (*params != '\0' && !isspace(*params)) params++;                      // Split command and parameters
+    if (*params != '\0') *params++ = '\0';
+    int value = (int)strtol(params,NULL,0);                                     // Many commands have a numeric parameter.
+    char *mods = params;
+    while (isspace(*mods)) mods++;                                              // Optional second numeric parameter
+    while (*mods != '\0' && !isspace(*mods)) mods++;
+    int modifiers = (int)strtol(mods,NULL,0);
+
+    if (strcmp(line,"wait") == 0) {                                             // wait <ms>
+        resumeTime = TMRReadTimeMS()+value;
+    } else if (strcmp(line,"type") == 0 || strcmp(line,"line") == 0) {          // type <text> and line <text>
+        strcpy(pendingText,params);pendingPos = 0;
+        if (line[0] == 'l') strcat(pendingText,"\r");
+    } else if (strcmp(line,"key") == 0) {                                       // key <code> [mods]
+        KBDReceiveEvent(1,value,modifiers);
+        KBDReceiveEvent(0,value,modifiers);
+    } else if (strcmp(line,"down") == 0 || strcmp(line,"up") == 0) {            // down/up <code> [mods]
+        KBDReceiveEvent(line[0] == 'd',value,modifiers);
+    } else if (strcmp(line,"capture") == 0) {                                   // capture <file>
+        if (!CAPWriteImage(params)) fprintf(stderr,"Cannot capture to '%s'\n",params);
+    } else if (strcmp(line,"hash") == 0) {                                      // hash
+        printf("hash %016llx\n",(unsigned long long)CAPHashDisplay());
+    } else if (strcmp(line,"quit") == 0) {                                      // quit [status]
+        SYSRequestExit(value);
+    } else {
+        fprintf(stderr,"Unknown script command '%s'\n",line);
+    }
+}
+
+/**
+ * @brief      Advance the script, called from the 50Hz yield
+ */
+void SCRUpdate(void) {
+    char line[SCR_LINE_SIZE];
+    while (true) {
+        if (pendingText[pendingPos] != '\0') {                                  // Text waiting to be typed, as much as fits.
+            pendingPos += KBDInsertQueueBulk(pendingText+pendingPos,strlen(pendingText+pendingPos));
+            if (pendingText[pendingPos] != '\0') return;
+        }
+        if (scriptFile == NULL || TMRReadTimeMS() < resumeTime) return;         // Nothing to do, or waiting.
+        if (fgets(line,sizeof(line),scriptFile) == NULL) {                      // End of script.
+            fclose(scriptFile);scriptFile = NULL;
+            return;
+        }
+        line[strcspn(line,"\r\n")] = '\0';                                      // Remove line ending.
+        char *p = line;
+        while (isspace(*p)) p++;
+        if (*p != '\0' && *p != '#') _SCRExecute(p);
+    }
+}
@@ -15,88 +15,116 @@
 static SDL_AudioDeviceID audioDevice;
 static SDL_AudioSpec audioSpec;
 
-void (*m_writeData)(uint8_t* ptr, double data);
-int (*m_calculateOffset)(int sample, int channel);
+#define SND_HOST_FREQUENCY  (44100)                                             // Rate requested from SDL
+#define SND_EMULATED_FREQUENCY (252000*1024/32/255)                            // Hardware PWM rate, as in internal/sound.c
+#define SND_RENDER_BLOCK    (256)                                               // Samples rendered at a time, as the DMA block
+
+//
+//      Samples are synthesised at the hardware rate by the audio callback, a block at a time
+//      as the hardware's DMA interrupt does, so sound keeps playing however long the application
+//      goes without calling SYSYield(). The block is only used by the callback thread.
+//
+static int8_t block[SND_RENDER_BLOCK];
+static int blockPosition = SND_RENDER_BLOCK;                                    // Next sample in the block
+
+static uint64_t lastCallback = 0;                                               // Performance counter at the last callback
+static uint64_t lastDuration = 0;                                               // Length of the audio it supplied, in counts
+static volatile uint32_t callbackUnderruns = 0;                                 // Callbacks too late to keep the device fed.
+
+static uint32_t resamplePosition = 0;                                           // 16.16 position between the two samples
+static int resampleLast = 0,resampleNext = 0;                                   // Samples either side of it.
 
 /**
- * @brief      Calculates the offset for s16 format
- *
- * @param[in]  sample   The sample count
- * @param[in]  channel  The channel number
+ * @brief      Get the next sample at the hardware rate, rendering a new
+ *             block when the last one has been used.
  *
- * @return     The offset s 16.
+ * @return     Sample -128 .. 127
  */
-static int calculateOffset_s16(int sample, int channel) {
-	return
-		(sample * sizeof(int16_t) * audioSpec.channels) +
-		(channel * sizeof(int16_t));
+static int _SOUNDNextSample(void) {
+	if (blockPosition == SND_RENDER_BLOCK) {
+		#if ARTURO_PROCESS_SOUND==1
+		SNDRenderBlock(block,SND_RENDER_BLOCK);
+		#else
+		for (int i = 0;i < SND_RENDER_BLOCK;i++) block[i] = ApplicationGetChannelSample(0);
+		#endif
+		blockPosition = 0;
+	}
+	return block[blockPosition++];
 }
 
 /**
- * @brief      Calculates the offset for f32 format
+ * @brief      Synthesise and resample to the device rate, with linear
+ *             interpolation in 16.16 fixed point.
  *
- * @param[in]  sample   The sample count
- * @param[in]  channel  The channel offset
- *
- * @return     The offset f 32.
+ * @param      out         16 bit output samples
+ * @param[in]  count       Number of samples
+ * @param[in]  deviceRate  Device sample rate
  */
-static int calculateOffset_f32(int sample, int channel) {
-	return
-		(sample * sizeof(float) * audioSpec.channels) +
-		(channel * sizeof(float));
+void SOUNDResample(int16_t *out,int count,int deviceRate) {
+	uint32_t step = ((uint32_t)SND_EMULATED_FREQUENCY << 16) / deviceRate;
+	for (int i = 0;i < count;i++) {
+		int frac = resamplePosition & 0xFFFF;
+		out[i] = (resampleLast << 8) + (((resampleNext-resampleLast) * frac) >> 8);
+		resamplePosition += step;
+		while (resamplePosition >= 0x10000) {                                   // Move on to the next sample
+			resamplePosition -= 0x10000;
+			resampleLast = resampleNext;
+			resampleNext = _SOUNDNextSample();
+		}
+	}
 }
 
 /**
- * @brief      Writes the normalised data value (0-1) to the output stream
- *             matching the audio format
+ * @brief      Count an underrun if the callback came later than twice the
+ *             length of the audio the last one supplied, as the device will
+ *             have run out of samples.
  *
- * @param      ptr   pointer into queue
- * @param[in]  data  Data
+ * @param[in]  now     Performance counter now
+ * @param[in]  frames  Sample frames being supplied now
  */
-static void writeData_s16(uint8_t* ptr, double data) {
-	int16_t* ptrTyped = (int16_t*)ptr;
-	double range = (double)INT16_MAX - (double)INT16_MIN;
-	double dataScaled = data * range / 2.0;
-	*ptrTyped = dataScaled;
+static void _SOUNDCheckCallbackTime(uint64_t now,int frames) {
+	if (lastCallback != 0 && now-lastCallback > 2*lastDuration) callbackUnderruns++;
+	lastCallback = now;
+	lastDuration = (uint64_t)frames * SDL_GetPerformanceFrequency() / audioSpec.freq;
 }
 
 /**
- * @brief      Writes the normalised data value (0-1) to the output stream
- *             matching the audio format
+ * @brief      Get the number of times the audio callback was too late
  *
- * @param      ptr   pointer into queue
- * @param[in]  data  Data
+ * @return     Underrun count, since starting.
  */
-static void writeData_f32(uint8_t* ptr, double data) {
-	float* ptrTyped = (float*)ptr;
-	*ptrTyped = data;
+uint32_t SOUNDGetUnderruns(void) {
+	return callbackUnderruns;
 }
 
 /**
- * @brief      Callback to repopulatoe sound buffer
+ * @brief      Callback to repopulate sound buffer
  *
  * @param      userdata   User data passed
  * @param      stream    Stream address
  * @param[in]  len       The length size in bytes
  */
 static void audioCallback(void* userdata,uint8_t* stream,int len) {
-	// Unused parameters
+	static int16_t samples[4096];
 	(void)userdata;
-	(void)len;
-	// Write data to the entire buffer by iterating through all samples and
-	// channels.
-	for (int sample = 0; sample < audioSpec.samples; ++sample) {
-		#if ARTURO_PROCESS_SOUND==1
-		double data = ((double)SNDGetChannelSample(0))/128.0;
-		#else		
-		double data = ((double)ApplicationGetChannelSample(0))/128.0;
-		#endif
-		// Write the same data to all channels
-		for (int channel = 0; channel < audioSpec.channels; ++channel) {
-			int offset = m_calculateOffset(sample, channel);
-			uint8_t* ptrData = stream + offset;
-			m_writeData(ptrData, data);
+	int bytesPerSample = (audioSpec.format == AUDIO_S16) ? sizeof(int16_t) : sizeof(float);
+	int total = len / bytesPerSample / audioSpec.channels;                     // Sample frames wanted
+	_SOUNDCheckCallbackTime(SDL_GetPerformanceCounter(),total);
+	int16_t *p16 = (int16_t *)stream;
+	float *pf = (float *)stream;
+	while (total > 0) {                                                         // A buffer at a time, until all filled.
+		int count = min(total,(int)(sizeof(samples)/sizeof(int16_t)));
+		SOUNDResample(samples,count,audioSpec.freq);
+		for (int i = 0;i < count;i++) {
+			for (int c = 0;c < audioSpec.channels;c++) {
+				if (audioSpec.format == AUDIO_S16) {                            // 16 bit, copy straight in.
+					*p16++ = samples[i];
+				} else {                                                        // Float
+					*pf++ = samples[i] / 32768.0f;
+				}
+			}
 		}
+		total -= count;
 	}
 }
 
@@ -111,7 +139,7 @@ void SOUNDOpen(void) {
 	SDL_zero(desiredSpec);
 
 	// Commonly used sampling frequency
-	desiredSpec.freq = 44100;
+	desiredSpec.freq = SND_HOST_FREQUENCY;
 
 	// Currently this program supports two audio formats:
 	// - AUDIO_S16: 16 bits per sample
@@ -161,13 +189,9 @@ void SOUNDOpen(void) {
 	} else {
 		switch (audioSpec.format) {
 			case AUDIO_S16:
-				m_writeData = writeData_s16;
-				m_calculateOffset = calculateOffset_s16;
 				formatName = "AUDIO_S16";
 				break;
 			case AUDIO_F32:
-				m_writeData = writeData_f32;
-				m_calculateOffset = calculateOffset_f32;
 				formatName = "AUDIO_F32";
 				break;
 			default:
@@ -178,11 +202,28 @@ void SOUNDOpen(void) {
 	}
 }
 
+/**
+ * @brief      Hold off the audio callback, which runs the mixer on SDL's
+ *             audio thread, while a channel is changed. SDL holds the same
+ *             lock while it calls the callback.
+ */
+void SNDLockMixer(void) {
+	if (audioDevice != 0) SDL_LockAudioDevice(audioDevice);
+}
+
+/**
+ * @brief      Let the audio callback run again
+ */
+void SNDUnlockMixer(void) {
+	if (audioDevice != 0) SDL_UnlockAudioDevice(audioDevice);
+}
+
 /**
  * @brief      Close the sound device
  */
 void SOUNDClose(void) {
 	SDL_CloseAudioDevice(audioDevice);
+	audioDevice = 0;
 }
 
 
@@ -190,6 +231,7 @@ void SOUNDClose(void) {
  * @brief      Start playing audio
  */
 void SOUNDPlay(void) {
+	lastCallback = 0;                                                           // Not late after a pause.
 	SDL_PauseAudioDevice(audioDevice, 0);
 }
 
@@ -211,10 +253,11 @@ void SOUNDStop(void) {
  * @brief      Get the sample rate
  *
  *             This returns the sample rate required by the sound system and is
- *             read by audio systems to know the signal to send
+ *             read by audio systems to know the signal to send. This is the
+ *             hardware's rate, so pitches are calculated the same way.
  *
  * @return     Sample rate in Hz
  */
 int SNDGetSampleFrequency(void) {
-    return audioSpec.freq;
+    return SND_EMULATED_FREQUENCY;                                              // Resampled to the device rate in the callback
 }
@@ -75,7 +75,13 @@ int SYSPollUpdate(void) {
             int ctrl = ((SDL_GetModState() & KMOD_LCTRL) != 0);                     // If control pressed
             if (ctrl == 0) isRunning = 0;                                           // Exit
         }
-        if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {                 // Handle other keys, which may go up or down.
+        if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F12) {        // F12 captures the display
+            CAPCaptureNext();
+        } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F11) { // F11 toggles the performance overlay
+            HUDToggle();
+        } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F10) { // F10 toggles the write heat map
+            RNDToggleHeatMap();
+        } else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {          // Handle other keys, which may go up or down.
             KBDProcessEvent(event.key.keysym.scancode,SDL_GetModState(),event.type == SDL_KEYDOWN);
         }
         if (event.type == SDL_MOUSEMOTION || event.type == SDL_MOUSEBUTTONDOWN      // Mouse button/position update
@@ -92,8 +98,14 @@ int SYSPollUpdate(void) {
             isRunning = 0;
         }
     }
+    CTLCheckControllers();                                                          // Queue controller changes
     frameCount++;
+    Uint64 renderStart = SDL_GetPerformanceCounter();
     RNDRender(mainSurface);
+    PRFCount(PRF_RENDER_TIME,(SDL_GetPerformanceCounter()-renderStart)*1000000/SDL_GetPerformanceFrequency());
+    CAPEndFrame();                                                                  // Hash/capture the frame if required
+    CSTEndFrame();                                                                  // Estimate the hardware cost of the frame
+    HUDEndFrame();                                                                  // Draw performance overlay if enabled
     SDL_UpdateWindowSurface(mainWindow);                                            // And update the main window.  
     return isRunning;
 }
@@ -107,6 +119,8 @@ void SYSClose(void) {
     SOUNDStop();
     SDL_CloseAudio();                                                               // Shut audio up.
     SDL_Quit();                                                                     // Exit SDL.
+    CAPClose();
+    CSTClose();
     printf("Frame Rate %.2f\n",frameCount/((endTime-startTime)/1000.0));
 }
 